@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "core/image_processor.h"
+#include "filters/kernels/kernels.h"
+#include "filters/geometric.h"
+#include "filters/registry.h"
+
+using namespace imagetui;
+namespace fs = std::filesystem;
+
+namespace
+{
+  struct Options
+  {
+    int warmup = 2;
+    int iterations = 10;
+    std::vector<cv::Size> sizes = {{1280, 720}, {1920, 1080}, {4000, 3000}};
+    std::vector<int> channels = {1, 3, 4};
+    std::vector<std::string> only;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 5.0;
+  };
+
+  struct Result
+  {
+    std::string name;
+    cv::Size size;
+    int channels = 3;
+    int iterations = 0;
+    double medianMs = 0.0;
+    double p99Ms = 0.0;
+    double mpPerSec = 0.0;
+    double bytesPerPixel = 0.0;
+
+    std::string key() const
+    {
+      std::ostringstream out;
+      out << name << "@" << size.width << "x" << size.height << "x" << channels;
+      return out.str();
+    }
+  };
+
+  std::vector<std::string> split(const std::string &text, char separator)
+  {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator))
+      if (!part.empty())
+        parts.push_back(part);
+    return parts;
+  }
+
+  // Smooth gradients plus a little deterministic noise, so the codecs see
+  // something closer to a photo than flat color or pure noise.
+  cv::Mat syntheticImage(cv::Size size, int channels)
+  {
+    cv::Mat mat(size, CV_8UC(channels));
+    uint32_t state = 0x9e3779b9u;
+    for (int y = 0; y < size.height; y++)
+    {
+      uchar *row = mat.ptr<uchar>(y);
+      for (int x = 0; x < size.width; x++)
+      {
+        for (int c = 0; c < channels; c++)
+        {
+          state = state * 1664525u + 1013904223u;
+          int value = (x * (c + 1) * 255 / size.width + y * 255 / size.height) / 2 + static_cast<int>(state >> 29);
+          row[x * channels + c] = static_cast<uchar>(std::min(255, value));
+        }
+      }
+    }
+    return mat;
+  }
+
+  double frameSize(const cv::Mat &mat)
+  {
+    return static_cast<double>(mat.total()) * mat.elemSize();
+  }
+
+  // `body` returns false on failure; a case that fails once is dropped.
+  template <typename Body>
+  std::optional<Result> measure(const std::string &name, cv::Size size, int channels, const Options &options, Body body)
+  {
+    for (int i = 0; i < options.warmup; i++)
+      if (!body())
+        return std::nullopt;
+
+    std::vector<double> samples;
+    samples.reserve(options.iterations);
+    for (int i = 0; i < options.iterations; i++)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      bool ok = body();
+      auto t1 = std::chrono::steady_clock::now();
+      if (!ok)
+        return std::nullopt;
+      samples.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.size = size;
+    result.channels = channels;
+    result.iterations = options.iterations;
+    result.medianMs = samples[samples.size() / 2];
+    // Nearest-rank percentile; with few iterations this is simply the slowest run.
+    size_t rank = static_cast<size_t>(0.99 * samples.size() + 0.999999);
+    result.p99Ms = samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    double megapixels = 1e-6 * size.width * size.height;
+    result.mpPerSec = result.medianMs > 0.0 ? megapixels / (result.medianMs / 1000.0) : 0.0;
+    return result;
+  }
+
+  bool selected(const Options &options, const std::string &name)
+  {
+    if (options.only.empty())
+      return true;
+    for (const auto &want : options.only)
+      if (name.find(want) != std::string::npos)
+        return true;
+    return false;
+  }
+
+  std::vector<Result> runAll(const Options &options)
+  {
+    std::vector<Result> results;
+    const fs::path tempDir = fs::temp_directory_path() / "imagetui_bench";
+    fs::create_directories(tempDir);
+
+    for (const auto &size : options.sizes)
+    {
+      for (int channels : options.channels)
+      {
+        core::ImageData input(syntheticImage(size, channels));
+        const double pixels = static_cast<double>(size.width) * size.height;
+        const double frameBytes = frameSize(input.getMat());
+
+        for (const auto &info : filters::FilterRegistry::filters())
+        {
+          const std::string name = "filter/" + info.name;
+          if (!selected(options, name))
+            continue;
+
+          core::Pipeline pipeline;
+          if (!filters::FilterRegistry::buildPipeline(info.name, pipeline))
+            continue;
+
+          std::unique_ptr<core::ImageData> output;
+          auto result = measure(name, size, channels, options, [&]
+                                { return (output = pipeline.run(input)) != nullptr; });
+          if (!result)
+            continue;
+          // One read of the source and one write of the result.
+          result->bytesPerPixel = (frameBytes + frameSize(output->getMat())) / pixels;
+          results.push_back(*result);
+        }
+
+        // Geometry changes the frame size, so it runs outside the pipeline.
+        struct GeometryCase
+        {
+          std::string name;
+          std::function<std::unique_ptr<core::ImageData>()> body;
+        };
+        const cv::Size half(size.width / 2, size.height / 2);
+        const GeometryCase geometry[] = {
+            {"geometry/rotate90", [&]
+             { return filters::GeometricFilters::rotate(input, 90); }},
+            {"geometry/flip-vertical", [&]
+             { return filters::GeometricFilters::flip(input, filters::FlipMode::Vertical); }},
+            {"geometry/resize-half", [&]
+             { return filters::GeometricFilters::resize(input, half); }},
+        };
+
+        for (const auto &test : geometry)
+        {
+          if (!selected(options, test.name))
+            continue;
+
+          std::unique_ptr<core::ImageData> output;
+          auto result = measure(test.name, size, channels, options, [&]
+                                { return (output = test.body()) != nullptr; });
+          if (!result)
+            continue;
+          result->bytesPerPixel = (frameBytes + frameSize(output->getMat())) / pixels;
+          results.push_back(*result);
+        }
+
+        for (const std::string ext : {"png", "jpg", "bmp"})
+        {
+          // One file per size and channel count, so a load case never reads a
+          // file written for another input.
+          const std::string stem = "bench_" + std::to_string(size.width) + "x" + std::to_string(size.height) +
+                                   "_" + std::to_string(channels);
+          const std::string path = (tempDir / (stem + "." + ext)).string();
+
+          std::error_code ec;
+
+          if (selected(options, "save/" + ext))
+          {
+            auto result = measure("save/" + ext, size, channels, options, [&]
+                                  { return core::ImageProcessor::saveImageFast(path, input); });
+            if (result)
+            {
+              result->bytesPerPixel = (frameBytes + fs::file_size(path, ec)) / pixels;
+              results.push_back(*result);
+            }
+          }
+
+          // loadImage always decodes to 3-channel BGR, so one channel count is enough.
+          if (channels == 3 && selected(options, "load/" + ext))
+          {
+            if (!fs::exists(path) && !core::ImageProcessor::saveImageFast(path, input))
+              continue;
+
+            std::unique_ptr<core::ImageData> decoded;
+            auto result = measure("load/" + ext, size, 3, options, [&]
+                                  { return (decoded = core::ImageProcessor::loadImage(path)) != nullptr; });
+            if (result)
+            {
+              result->bytesPerPixel = (fs::file_size(path, ec) + frameSize(decoded->getMat())) / pixels;
+              results.push_back(*result);
+            }
+          }
+        }
+      }
+    }
+
+    std::error_code ec;
+    fs::remove_all(tempDir, ec);
+    return results;
+  }
+
+  std::string toJson(const std::vector<Result> &results, bool kernelsVerified)
+  {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"version\": \"" << PROJECT_VERSION << "\",\n";
+    out << "  \"kernels\": \"" << filters::kernels::active().name << "\",\n";
+    out << "  \"kernels_verified\": " << (kernelsVerified ? "true" : "false") << ",\n";
+    out << "  \"threads\": " << cv::getNumThreads() << ",\n";
+    out << "  \"results\": [\n";
+    // One result per line keeps baseline parsing trivial and diffs readable.
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      const Result &r = results[i];
+      out << "    {\"name\": \"" << r.name << "\", \"width\": " << r.size.width << ", \"height\": " << r.size.height
+          << ", \"channels\": " << r.channels << ", \"iterations\": " << r.iterations
+          << ", \"median_ms\": " << r.medianMs << ", \"p99_ms\": " << r.p99Ms
+          << ", \"mp_per_sec\": " << r.mpPerSec << ", \"bytes_per_pixel\": " << r.bytesPerPixel << "}"
+          << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+  }
+
+  std::string jsonString(const std::string &line, const std::string &key)
+  {
+    size_t pos = line.find("\"" + key + "\": \"");
+    if (pos == std::string::npos)
+      return "";
+    pos += key.size() + 5;
+    return line.substr(pos, line.find('"', pos) - pos);
+  }
+
+  double jsonNumber(const std::string &line, const std::string &key)
+  {
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == std::string::npos)
+      return 0.0;
+    return std::atof(line.c_str() + pos + key.size() + 4);
+  }
+
+  std::map<std::string, Result> loadBaseline(const std::string &path)
+  {
+    std::map<std::string, Result> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+      Result r;
+      r.name = jsonString(line, "name");
+      if (r.name.empty())
+        continue;
+      r.size = cv::Size(static_cast<int>(jsonNumber(line, "width")), static_cast<int>(jsonNumber(line, "height")));
+      r.channels = static_cast<int>(jsonNumber(line, "channels"));
+      r.medianMs = jsonNumber(line, "median_ms");
+      r.p99Ms = jsonNumber(line, "p99_ms");
+      baseline[r.key()] = r;
+    }
+    return baseline;
+  }
+
+  void printUsage(const char *program)
+  {
+    std::cerr << "Usage: " << program << " [options]" << std::endl;
+    std::cerr << "  --iterations <n>       Timed runs per case (default: 10)" << std::endl;
+    std::cerr << "  --warmup <n>           Untimed runs per case (default: 2)" << std::endl;
+    std::cerr << "  --sizes <WxH,...>      Image sizes (default: 1280x720,1920x1080,4000x3000)" << std::endl;
+    std::cerr << "  --channels <c,...>     Channel counts (default: 1,3,4)" << std::endl;
+    std::cerr << "  --only <substr,...>    Only cases whose name contains one of these" << std::endl;
+    std::cerr << "  --json <file>          Write results as JSON" << std::endl;
+    std::cerr << "  --baseline <file>      Compare against an earlier --json run" << std::endl;
+    std::cerr << "  --threshold <percent>  Median or p99 slowdown counted as a regression (default: 5)" << std::endl;
+  }
+
+  bool parseOptions(int argc, char *argv[], Options &options)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (i + 1 >= argc)
+        return false;
+
+      std::string value = argv[++i];
+      if (arg == "--iterations")
+        options.iterations = std::max(1, std::atoi(value.c_str()));
+      else if (arg == "--warmup")
+        options.warmup = std::max(0, std::atoi(value.c_str()));
+      else if (arg == "--only")
+        options.only = split(value, ',');
+      else if (arg == "--json")
+        options.jsonPath = value;
+      else if (arg == "--baseline")
+        options.baselinePath = value;
+      else if (arg == "--threshold")
+        options.threshold = std::atof(value.c_str());
+      else if (arg == "--channels")
+      {
+        options.channels.clear();
+        for (const auto &c : split(value, ','))
+          options.channels.push_back(std::clamp(std::atoi(c.c_str()), 1, 4));
+      }
+      else if (arg == "--sizes")
+      {
+        options.sizes.clear();
+        for (const auto &s : split(value, ','))
+        {
+          int w = 0, h = 0;
+          if (std::sscanf(s.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            return false;
+          options.sizes.emplace_back(w, h);
+        }
+      }
+      else
+        return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  const bool kernelsVerified = filters::kernels::verify(filters::kernels::active());
+  std::cout << "Kernels: " << filters::kernels::active().name
+            << (kernelsVerified ? " (matches scalar)" : " (MISMATCH vs scalar)") << std::endl;
+
+  std::vector<Result> results = runAll(options);
+
+  std::cout << std::left << std::setw(18) << "case" << std::setw(12) << "size" << std::setw(4) << "ch"
+            << std::right << std::setw(11) << "median ms" << std::setw(11) << "p99 ms"
+            << std::setw(10) << "MP/s" << std::setw(8) << "B/px" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  for (const auto &r : results)
+  {
+    std::ostringstream size;
+    size << r.size.width << "x" << r.size.height;
+    std::cout << std::left << std::setw(18) << r.name << std::setw(12) << size.str() << std::setw(4) << r.channels
+              << std::right << std::setw(11) << r.medianMs << std::setw(11) << r.p99Ms
+              << std::setw(10) << r.mpPerSec << std::setw(8) << r.bytesPerPixel << std::endl;
+  }
+
+  if (!options.jsonPath.empty())
+  {
+    std::ofstream out(options.jsonPath);
+    out << toJson(results, kernelsVerified);
+    std::cout << "Results written to " << options.jsonPath << std::endl;
+  }
+
+  int regressions = 0;
+  if (!options.baselinePath.empty())
+  {
+    auto baseline = loadBaseline(options.baselinePath);
+    std::cout << std::endl
+              << "Against " << options.baselinePath << " (median, p99):" << std::endl;
+
+    auto percentChange = [](double now, double before)
+    { return before > 0.0 ? (now / before - 1.0) * 100.0 : 0.0; };
+
+    for (const auto &r : results)
+    {
+      auto it = baseline.find(r.key());
+      if (it == baseline.end() || it->second.medianMs <= 0.0)
+        continue;
+
+      // Either the typical run or the tail getting slower counts.
+      double change = percentChange(r.medianMs, it->second.medianMs);
+      double tailChange = percentChange(r.p99Ms, it->second.p99Ms);
+      bool regressed = change > options.threshold || tailChange > options.threshold;
+      const char *verdict = regressed ? "REGRESSION" : (change < -options.threshold ? "faster" : "");
+      if (regressed)
+        regressions++;
+
+      std::cout << std::left << std::setw(36) << r.key() << std::right << std::setw(10) << it->second.medianMs
+                << " -> " << std::setw(10) << r.medianMs << std::showpos << std::setw(9) << change << "%"
+                << std::noshowpos << std::setw(10) << it->second.p99Ms << " -> " << std::setw(10) << r.p99Ms
+                << std::showpos << std::setw(9) << tailChange << "%" << std::noshowpos << "  " << verdict
+                << std::endl;
+    }
+    std::cout << regressions << " regression(s) over " << options.threshold << "%" << std::endl;
+  }
+
+  return (kernelsVerified && regressions == 0) ? 0 : 2;
+}
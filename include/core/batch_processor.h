@@ -0,0 +1,73 @@
+#pragma once
+#include "core/pipeline.h"
+#include "core/result_cache.h"
+#include <functional>
+#include <string>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    struct BatchOptions
+    {
+      std::string inputDir;
+      std::string outputDir;
+      // Output extension without the dot; empty keeps each input's extension.
+      std::string outputFormat;
+      // Quality and optional time/size limits for each output file.
+      EncodeBudget encode;
+
+      int decodeThreads = 0; // 0 = pick from hardware concurrency
+      int filterThreads = 0;
+      int encodeThreads = 0;
+      // Capacity of each of the two inter-stage queues.
+      int queueCapacity = 4;
+
+      // Replaces ImageProcessor::loadImage, e.g. to decode straight to a
+      // thumbnail. Whatever changes the loaded frame must also go into
+      // chainKey, as main.cpp does with the fit size, so its results are
+      // cached apart from full-size ones.
+      std::function<std::unique_ptr<ImageData>(const std::string &path)> load;
+
+      // Optional result cache; chainKey is the canonical filter spec that,
+      // with the input bytes and encoder settings, names each result.
+      ResultCache *cache = nullptr;
+      std::string chainKey;
+    };
+
+    struct BatchStats
+    {
+      int processed = 0;
+      int failed = 0;
+      // Of `processed`, outputs copied from the cache without decoding.
+      int cached = 0;
+      double megapixels = 0.0;
+      double wallSeconds = 0.0;
+      // Total time the workers of each stage spent busy, summed over threads.
+      double decodeSeconds = 0.0;
+      double filterSeconds = 0.0;
+      double encodeSeconds = 0.0;
+      // Most frames alive at the same time: decoded inputs, filter results
+      // and pipeline scratch.
+      int peakFramesInFlight = 0;
+
+      double megapixelsPerSecond() const { return wallSeconds > 0.0 ? megapixels / wallSeconds : 0.0; }
+    };
+
+    // Runs every image under inputDir through `pipeline` using three worker
+    // pools (decode, filter, encode) joined by bounded queues. Each filter
+    // thread holds its input, its result and the pipeline's scratch frame, so
+    // at most decode + 3 * filter + encode threads + 2 * queueCapacity frames
+    // are held in memory at once.
+    class BatchProcessor
+    {
+    public:
+      static BatchStats run(const BatchOptions &options, const Pipeline &pipeline);
+
+    private:
+      static std::vector<std::string> collectInputs(const std::string &inputDir);
+    };
+
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Blocking multi-producer/multi-consumer queue. push() waits while the queue
+    // is full, which is what throttles upstream stages. Once close() is called,
+    // push() fails and pop() drains what is left before returning nullopt.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+      explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+      bool push(T item)
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&]
+                     { return closed || items.size() < capacity; });
+        if (closed)
+          return false;
+
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+      }
+
+      std::optional<T> pop()
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&]
+                      { return closed || !items.empty(); });
+        if (items.empty())
+          return std::nullopt;
+
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+      }
+
+      void close()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+      }
+
+    private:
+      const size_t capacity;
+      std::deque<T> items;
+      bool closed = false;
+      std::mutex mutex;
+      std::condition_variable notEmpty;
+      std::condition_variable notFull;
+    };
+
+  }
+}
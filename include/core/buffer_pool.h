@@ -0,0 +1,56 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Size-classed frame allocator. Mats created through it hand their memory
+    // back to the pool when the last reference goes away, so the next frame of
+    // a similar size reuses the same pages instead of going through malloc,
+    // munmap and fresh page faults every time.
+    class BufferPool : public cv::MatAllocator
+    {
+    public:
+      struct Stats
+      {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t retainedBytes = 0;
+        size_t outstandingBytes = 0;
+      };
+
+      static BufferPool &instance();
+
+      // Allocates `mat` from the shared pool (no-op if it already has that shape).
+      static void create(cv::Mat &mat, int rows, int cols, int type);
+
+      void setMaxRetainedBytes(size_t bytes);
+      void trim();
+      Stats stats() const;
+
+      cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                             cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+      bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+      void deallocate(cv::UMatData *data) const override;
+
+    private:
+      BufferPool() = default;
+
+      static size_t sizeClass(size_t bytes);
+      void *acquire(size_t bytes) const;
+      void release(void *ptr, size_t bytes) const;
+
+      mutable std::mutex mutex;
+      mutable std::unordered_map<size_t, std::vector<void *>> freeLists;
+      mutable Stats counters;
+      size_t maxRetainedBytes = size_t(512) << 20;
+    };
+
+  }
+}
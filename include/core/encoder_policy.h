@@ -0,0 +1,77 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // What a caller is willing to spend on one encode. Zero means no limit.
+    struct EncodeBudget
+    {
+      double maxEncodeMs = 0.0;
+      size_t maxBytes = 0;
+      // Lossy formats start at `quality` and step down towards `minQuality`
+      // while the output is over maxBytes.
+      int quality = 85;
+      int minQuality = 0;
+      // Used instead of `quality` for WebP when set (> 0).
+      int webpQuality = 0;
+
+      // A time limit nothing can meet, so every choice takes its cheapest option.
+      static EncodeBudget fastest();
+    };
+
+    // Cheap statistics from a sample of rows, used to predict how well an
+    // image compresses and which PNG strategy suits it.
+    struct ContentStats
+    {
+      // Shannon entropy of left-neighbour residuals, in bits per byte (0-8).
+      double residualEntropy = 8.0;
+      // Fraction of sampled pixels identical to their left neighbour.
+      double flatness = 0.0;
+
+      static ContentStats measure(const cv::Mat &image);
+    };
+
+    enum class EncoderBackend
+    {
+      OpenCV,
+      Stb, // bundled stb_image_write, for formats OpenCV was built without
+    };
+
+    struct EncodePlan
+    {
+      std::string format; // lower-case extension without the dot
+      EncoderBackend backend = EncoderBackend::OpenCV;
+      std::vector<int> params; // cv::imwrite parameters
+      int quality = 0;         // lossy quality, 0 for lossless formats
+      double predictedMs = 0.0;
+      size_t predictedBytes = 0;
+    };
+
+    // Picks encoder parameters per image from its size, content and a budget.
+    // Time predictions start from a built-in throughput table and are refined
+    // from every encode that goes through encode(), so a long batch converges
+    // on the speed of the machine it runs on.
+    class EncoderPolicy
+    {
+    public:
+      static EncodePlan choose(const std::string &filename, const cv::Mat &image, const EncodeBudget &budget);
+
+      // Encodes per `plan`, re-encoding lossy formats at lower quality while
+      // the result is over budget.maxBytes, then writes the file.
+      static bool encode(const std::string &filename, const cv::Mat &image, const EncodePlan &plan,
+                         const EncodeBudget &budget);
+
+    private:
+      static bool encodeToMemory(const cv::Mat &image, const EncodePlan &plan, std::vector<uchar> &bytes);
+      static double throughput(const std::string &key);
+      static void observe(const std::string &key, double megapixels, double ms);
+    };
+
+  }
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "core/buffer_pool.h"
+#include "core/encoder_policy.h"
 #include <opencv2/core.hpp>
 #include <string>
 #include <functional>
@@ -18,7 +20,9 @@ namespace imagetui
 
       ImageData() = default;
       explicit ImageData(cv::Mat m) : mat(std::move(m)) {}
-      ImageData(int width, int height, int type) : mat(height, width, type) {}
+      // Storage comes from the shared BufferPool and returns to it once the
+      // last cv::Mat referencing it is released.
+      ImageData(int width, int height, int type) { BufferPool::create(mat, height, width, type); }
 
       bool isValid() const { return !mat.empty(); }
       int width() const { return mat.cols; }
@@ -33,12 +37,17 @@ namespace imagetui
     {
     public:
       static std::unique_ptr<ImageData> loadImage(const std::string &filename);
+      // For thumbnails: JPEGs decode at the coarsest DCT scale (1/2, 1/4 or
+      // 1/8) that still covers fitWithin(size, bounds), so the full frame is
+      // never materialized. Other formats decode at full size.
+      static std::unique_ptr<ImageData> loadImageReduced(const std::string &filename, cv::Size bounds);
+      // Largest size with the same aspect ratio that fits in `bounds`; never
+      // larger than `size`.
+      static cv::Size fitWithin(cv::Size size, cv::Size bounds);
+      // Encoder parameters are picked per image by EncoderPolicy to fit the budget.
+      static bool saveImage(const std::string &filename, const ImageData &image, const EncodeBudget &budget);
       static bool saveImageFast(const std::string &filename, const ImageData &image, int quality = 85);
       static bool saveImageUltraFast(const std::string &filename, const ImageData &image);
-
-    private:
-      static std::vector<int> getCompressionParams(const std::string &filename, int quality);
-      static std::vector<int> getUltraFastParams(const std::string &filename);
     };
 
   }
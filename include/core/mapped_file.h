@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Read-only memory mapping of a whole file. Decoders read straight from
+    // the page cache instead of going through a stdio copy.
+    class MappedFile
+    {
+    public:
+      static std::unique_ptr<MappedFile> open(const std::string &filename);
+      ~MappedFile();
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      const unsigned char *data() const { return bytes; }
+      size_t size() const { return length; }
+
+    private:
+      MappedFile() = default;
+
+      const unsigned char *bytes = nullptr;
+      size_t length = 0;
+#ifdef _WIN32
+      void *fileHandle = nullptr;
+      void *mappingHandle = nullptr;
+#endif
+    };
+
+  }
+}
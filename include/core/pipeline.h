@@ -0,0 +1,71 @@
+#pragma once
+#include "core/image_processor.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Where a row sits in the full image, so position-dependent point ops
+    // (vignette, noise) work the same on the whole frame or on a strip of it.
+    struct RowContext
+    {
+      int y;
+      cv::Size imageSize;
+    };
+
+    // Rewrites one row of interleaved pixels in place.
+    using PointOp = std::function<void(uchar *row, int width, int channels, const RowContext &ctx)>;
+
+    // Writes dst rows [rows.start, rows.end) reading src rows up to `halo` away.
+    using NeighborhoodOp = std::function<void(const cv::Mat &src, cv::Mat &dst, const cv::Range &rows)>;
+
+    // Set from any thread to make a running pipeline stop at the next tile.
+    using CancelToken = std::atomic<bool>;
+
+    // Lazily recorded filter chain. Consecutive point ops are fused and run
+    // together on each row while it is still in cache; a neighborhood op starts
+    // a new segment that reads the previous segment's output with its halo.
+    // A chain of any length touches at most one scratch frame plus the output.
+    class Pipeline
+    {
+    public:
+      Pipeline &then(PointOp op);
+      Pipeline &thenNeighborhood(NeighborhoodOp op, int halo);
+
+      bool empty() const { return segments.empty(); }
+      int halo() const;
+      // Frames the size of the input that runStrip allocates besides dst.
+      int scratchFrames() const { return segments.size() > 1 ? 1 : 0; }
+
+      // Returns nullptr if `cancel` was set before the chain finished.
+      std::unique_ptr<ImageData> run(const ImageData &input, const CancelToken *cancel = nullptr) const;
+
+      // Runs the chain over `src`, a band of rows starting at row `yOffset` of
+      // an image of `imageSize`. Output rows within halo() of a band edge that
+      // is not also an image edge only see part of their neighbourhood, so
+      // callers pass halo() extra rows on each side and keep the middle.
+      bool runStrip(const cv::Mat &src, cv::Mat &dst, int yOffset, cv::Size imageSize,
+                    const CancelToken *cancel = nullptr) const;
+
+    private:
+      struct Segment
+      {
+        NeighborhoodOp gather;
+        int halo = 0;
+        std::vector<PointOp> points;
+      };
+
+      static bool runSegment(const Segment &segment, const cv::Mat &src, cv::Mat &dst,
+                             int yOffset, cv::Size imageSize, const CancelToken *cancel);
+      static int tileRows(const cv::Mat &mat);
+
+      std::vector<Segment> segments;
+    };
+
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "core/image_processor.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Identifies either an input file's bytes (params == 0) or one result
+    // derived from them.
+    struct CacheKey
+    {
+      uint64_t content = 0;
+      uint64_t length = 0;
+      uint64_t params = 0;
+
+      std::string name() const;
+    };
+
+    struct CacheOptions
+    {
+      // Empty keeps the cache in memory only.
+      std::string directory;
+      size_t maxDiskBytes = size_t(1) << 30;
+      size_t maxMemoryBytes = size_t(256) << 20;
+    };
+
+    struct CacheStats
+    {
+      size_t memoryHits = 0;
+      size_t diskHits = 0;
+      size_t misses = 0;
+      size_t memoryEvictions = 0;
+      size_t diskEvictions = 0;
+      size_t memoryBytes = 0;
+      size_t diskBytes = 0;
+    };
+
+    // Content-addressed cache of encoded outputs, with an in-memory LRU in
+    // front of an on-disk LRU. Disk entries are files named by key holding the
+    // result's pixel count and then its encoded bytes; their modification time
+    // is their recency, so the order survives restarts. Safe to share between
+    // threads.
+    class ResultCache
+    {
+    public:
+      explicit ResultCache(CacheOptions options);
+
+      // Hashes the file's bytes through a read-only mapping.
+      static std::optional<CacheKey> inputKey(const std::string &filename);
+      // Key of the result of `chain` (a canonical spec) encoded with `encoder`.
+      static CacheKey resultKey(const CacheKey &input, const std::string &chain, const std::string &encoder);
+      // Everything that decides the bytes ImageProcessor::saveImage writes.
+      static std::string encoderSignature(const std::string &outputPath, const EncodeBudget &budget);
+
+      // On a hit writes the cached bytes to `outputPath`, sets `pixels` to the
+      // size of the image they hold and returns true.
+      bool fetch(const CacheKey &key, const std::string &outputPath, uint64_t *pixels = nullptr);
+      // Records the file just written to `outputPath`, an image of `pixels`
+      // pixels, as the result for `key`.
+      void store(const CacheKey &key, const std::string &outputPath, uint64_t pixels);
+
+      CacheStats stats() const;
+
+    private:
+      struct MemoryEntry
+      {
+        std::string name;
+        // Shared so a hit can write it out after the lock is released.
+        std::shared_ptr<const std::vector<uchar>> encoded;
+        uint64_t pixels = 0;
+        size_t bytes = 0;
+      };
+
+      struct DiskEntry
+      {
+        std::string name;
+        size_t bytes = 0;
+      };
+
+      void loadIndex();
+      void insertMemory(MemoryEntry entry);
+      void insertDisk(const std::string &name, size_t bytes);
+      std::string diskPath(const std::string &name) const;
+
+      CacheOptions options;
+      mutable std::mutex mutex;
+      CacheStats counters;
+
+      // Most recently used first.
+      std::list<MemoryEntry> memory;
+      std::unordered_map<std::string, std::list<MemoryEntry>::iterator> memoryIndex;
+      std::list<DiskEntry> disk;
+      std::unordered_map<std::string, std::list<DiskEntry>::iterator> diskIndex;
+    };
+
+  }
+}
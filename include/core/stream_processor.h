@@ -0,0 +1,39 @@
+#pragma once
+#include "core/pipeline.h"
+#include <string>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    struct StreamOptions
+    {
+      int stripRows = 256;
+      int quality = 85;
+    };
+
+    struct StreamStats
+    {
+      int strips = 0;
+      double megapixels = 0.0;
+      double seconds = 0.0;
+      // Bytes held by the strip window plus the strip output.
+      size_t peakStripBytes = 0;
+      bool streamedInput = false;
+      bool streamedOutput = false;
+    };
+
+    // Runs `pipeline` over an image one strip at a time, so peak memory
+    // depends on stripRows + 2 * halo rows rather than on the image height.
+    // This holds when both ends stream (see StripReader/StripWriter); other
+    // formats still work but hold the full frame on that side.
+    class StreamProcessor
+    {
+    public:
+      static bool run(const std::string &input, const std::string &output, const Pipeline &pipeline,
+                      const StreamOptions &options, StreamStats *stats = nullptr);
+    };
+
+  }
+}
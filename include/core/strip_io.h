@@ -0,0 +1,51 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <memory>
+#include <string>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    // Hands out an image top to bottom, a few rows at a time, as 8-bit BGR.
+    // BMP and binary PPM are read straight from a file mapping. Other formats
+    // go through the regular decoder, so the whole frame is resident.
+    class StripReader
+    {
+    public:
+      static std::unique_ptr<StripReader> open(const std::string &filename);
+      virtual ~StripReader() = default;
+
+      cv::Size size() const { return imageSize; }
+      bool streaming() const { return incremental; }
+
+      // Fills `rows` (CV_8UC3, image width wide) with the next rows.mat.rows rows.
+      virtual bool read(cv::Mat &rows) = 0;
+
+    protected:
+      cv::Size imageSize;
+      bool incremental = true;
+    };
+
+    // Takes an image top to bottom as 8-bit BGR rows. BMP, PPM and PNG are
+    // encoded as rows arrive; PNG uses stored (uncompressed) deflate blocks,
+    // which matches the PNG_COMPRESSION 0 fast path. Other formats buffer the
+    // full frame and are encoded by finish().
+    class StripWriter
+    {
+    public:
+      static std::unique_ptr<StripWriter> open(const std::string &filename, cv::Size size, int quality);
+      virtual ~StripWriter() = default;
+
+      bool streaming() const { return incremental; }
+
+      virtual bool write(const cv::Mat &rows) = 0;
+      virtual bool finish() = 0;
+
+    protected:
+      bool incremental = true;
+    };
+
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/image_processor.h"
+#include "core/pipeline.h"
 
 namespace imagetui
 {
@@ -10,18 +11,28 @@ namespace imagetui
     public:
       static std::unique_ptr<core::ImageData> sepia(const core::ImageData &input);
       static std::unique_ptr<core::ImageData> vignette(const core::ImageData &input, float strength = 0.8f);
-      static std::unique_ptr<core::ImageData> noise(const core::ImageData &input, int strength = 25);
+      // Same seed, same output, whatever the thread count or tiling.
+      static std::unique_ptr<core::ImageData> noise(const core::ImageData &input, int strength = 25, uint32_t seed = 0);
+      // Keeps the per-bin channel sums over a (2r+1)^2 window within int.
+      static constexpr int kMaxOilRadius = 255;
+
+      // Radius is clamped to [1, kMaxOilRadius].
       static std::unique_ptr<core::ImageData> oilPainting(const core::ImageData &input, int radius = 3, int intensity = 20);
 
+      // Sepia mixes channels, so it stays on the color-matrix kernel rather
+      // than per-channel lookup tables.
+      static core::PointOp sepiaOp();
+      // Darkens toward the corners; strength 0..1 is the fraction taken off them.
+      static core::PointOp vignetteOp(float strength);
+      static core::PointOp noiseOp(int strength, uint32_t seed);
+      static core::NeighborhoodOp oilPaintingOp(int radius, int intensity);
+
     private:
-      static void horizontalOilPass(const cv::Mat &src, cv::Mat &dst, int radius, int intensity);
-      static void verticalOilPass(const cv::Mat &src, cv::Mat &dst, int radius, int intensity);
-      static int findDominantIntensity(const std::vector<int> &counts);
-      static void setOilPixel(cv::Mat &dst, int row, int col, int maxIdx,
-                              const std::vector<int> &counts,
-                              const std::vector<float> &avgR,
-                              const std::vector<float> &avgG,
-                              const std::vector<float> &avgB);
+      // Oil painting bins at most this many intensity levels.
+      static constexpr int kMaxOilLevels = 256;
+
+      static void oilPaintingTile(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile,
+                                  int radius, int levels, int *columnHistograms);
     };
   }
 }
\ No newline at end of file
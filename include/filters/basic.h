@@ -1,5 +1,6 @@
 #pragma once
 #include "core/image_processor.h"
+#include "core/pipeline.h"
 
 namespace imagetui
 {
@@ -9,6 +10,8 @@ namespace imagetui
     {
     public:
       static std::unique_ptr<core::ImageData> grayscale(const core::ImageData &input);
+
+      static core::PointOp grayscaleOp();
     };
   }
-}
\ No newline at end of file
+}
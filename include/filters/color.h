@@ -0,0 +1,23 @@
+#pragma once
+#include "core/image_processor.h"
+#include "core/pipeline.h"
+#include <array>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    class ColorFilters
+    {
+    public:
+      static std::unique_ptr<core::ImageData> invert(const core::ImageData &input);
+      static std::unique_ptr<core::ImageData> brightness(const core::ImageData &input, int delta);
+
+      static core::PointOp invertOp();
+      static core::PointOp brightnessOp(int delta);
+
+      // Maps every color byte through `table`; alpha is left alone.
+      static core::PointOp lookupOp(const std::array<uint8_t, 256> &table);
+    };
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "core/image_processor.h"
+#include "core/pipeline.h"
+
+namespace imagetui
+{
+  namespace filters
+  {
+    // Tone curves, each tabulated once per op so the per-pixel work is a
+    // table lookup.
+    class EnhancementFilters
+    {
+    public:
+      static std::unique_ptr<core::ImageData> contrast(const core::ImageData &input, float factor);
+      static std::unique_ptr<core::ImageData> gamma(const core::ImageData &input, float gamma);
+
+      // Scales distance from mid-gray by `factor`.
+      static core::PointOp contrastOp(float factor);
+      // out = 255 * (in / 255)^(1 / gamma); gamma > 1 lifts the shadows.
+      static core::PointOp gammaOp(float gamma);
+    };
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "core/image_processor.h"
+#include "core/pipeline.h"
+#include <string>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    enum class FlipMode
+    {
+      Horizontal,
+      Vertical,
+      Both
+    };
+
+    class GeometricFilters
+    {
+    public:
+      // A view into `input`: shares its pixels, so nothing is copied and
+      // writes show through. The rect is clipped to the image; returns nullptr
+      // if nothing is left.
+      static std::unique_ptr<core::ImageData> crop(const core::ImageData &input, const cv::Rect &rect);
+      static std::unique_ptr<core::ImageData> flip(const core::ImageData &input, FlipMode mode);
+      // Clockwise, in multiples of 90 degrees.
+      static std::unique_ptr<core::ImageData> rotate(const core::ImageData &input, int degrees);
+      // Separable triangle filter; widens to an area average when shrinking.
+      static std::unique_ptr<core::ImageData> resize(const core::ImageData &input, cv::Size size);
+
+      // Decodes `filename` already shrunk to fit `bounds`; see
+      // ImageProcessor::loadImageReduced.
+      static std::unique_ptr<core::ImageData> loadFitted(const std::string &filename, cv::Size bounds);
+
+      // Horizontal flip as a gather stage, so it fuses with the point ops that
+      // follow it and works on strips.
+      static core::NeighborhoodOp mirrorOp();
+
+    private:
+      // Pixels per side of a rotation block; a source and a destination block
+      // of 4-byte pixels fit in L1 together.
+      static constexpr int kRotateBlock = 64;
+
+      static void rotateQuarter(const cv::Mat &src, cv::Mat &dst, bool clockwise);
+      static void reverseRows(const cv::Mat &src, cv::Mat &dst, bool reversePixels);
+    };
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "core/pipeline.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    struct FilterInfo
+    {
+      std::string name;
+      std::string usage;
+      // Values for omitted trailing arguments; append() always sees them filled in.
+      std::vector<std::string> defaults;
+      // Arguments measured in pixels, such as radii, which scale with the image.
+      std::vector<size_t> pixelArgs;
+      std::function<bool(core::Pipeline &pipeline, const std::vector<std::string> &args)> append;
+    };
+
+    // Name -> pipeline stage table used by the command line. A chain is written
+    // as "name[:arg[:arg]][,name...]", e.g. "sepia,oil:5:20".
+    class FilterRegistry
+    {
+    public:
+      static const std::vector<FilterInfo> &filters();
+      static const FilterInfo *find(const std::string &name);
+      // `scale` is the size of the image the pipeline will run on relative to
+      // the one the spec was written for; pixel arguments are scaled by it,
+      // to at least 1.
+      static bool buildPipeline(const std::string &spec, core::Pipeline &pipeline, double scale = 1.0);
+
+      // Rewrites a chain with defaults filled in and numbers normalized, so
+      // "oil", "oil:3" and "oil:03:20" all name the same result.
+      static bool canonicalSpec(const std::string &spec, std::string &canonical);
+
+    private:
+      struct Stage
+      {
+        const FilterInfo *info;
+        std::vector<std::string> args;
+      };
+
+      static bool parseChain(const std::string &spec, std::vector<Stage> &stages);
+    };
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "core/image_processor.h"
+#include <string>
+#include <vector>
+
+namespace imagetui
+{
+  namespace ui
+  {
+
+    // Successively halved copies of an image; level 0 is the original.
+    class ImagePyramid
+    {
+    public:
+      explicit ImagePyramid(const core::ImageData &image, int minSide = 32);
+
+      int levels() const { return static_cast<int>(mats.size()); }
+      const cv::Mat &level(int index) const { return mats[index]; }
+
+      // Smallest level that still covers `target`, so a preview never has to
+      // be upscaled and never filters more pixels than it shows.
+      int levelFor(cv::Size target) const;
+
+    private:
+      std::vector<cv::Mat> mats;
+    };
+
+    struct TuiOptions
+    {
+      // Where 's' writes the full-resolution result; empty disables saving.
+      std::string outputPath;
+      std::string initialFilter = "sepia";
+    };
+
+    // Interactive preview in the terminal, drawn with half-block characters in
+    // 24-bit color. Each change is filtered on the pyramid level that fits the
+    // terminal first, then refined level by level up to full resolution in the
+    // background; a newer change cancels the refinement in flight.
+    class Tui
+    {
+    public:
+      static int run(const core::ImageData &image, const TuiOptions &options);
+    };
+
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace imagetui
+{
+  namespace utils
+  {
+    namespace trace
+    {
+
+      // Span names must be string literals: the pointer is stored as-is and
+      // never copied, so recording a span costs two timestamps and one store.
+      struct StaticName
+      {
+        const char *value;
+        template <size_t N>
+        consteval StaticName(const char (&literal)[N]) : value(literal) {}
+      };
+
+      struct StageSummary
+      {
+        std::string name;
+        uint64_t count = 0;
+        double totalMs = 0.0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+      };
+
+      // Recording is off until enabled; while off a span is one relaxed load,
+      // so the flag and its accessors live here rather than out of line.
+      inline std::atomic<bool> recording{false};
+
+      inline void setEnabled(bool enabled) { recording.store(enabled, std::memory_order_relaxed); }
+      inline bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+      uint64_t nowNs();
+      void record(const char *name, uint64_t startNs, uint64_t endNs);
+
+      // Readers below expect recording threads to be idle (e.g. after a batch
+      // has finished); events are kept in fixed per-thread rings, and the
+      // oldest ones are overwritten when a ring wraps. A ring outlives its
+      // thread and is handed to the next thread that starts recording, so
+      // memory follows the most threads alive at once, not thread churn.
+      std::vector<StageSummary> summarize();
+      std::string summary();
+      bool writeChromeTrace(const std::string &path);
+      void reset();
+
+      class Span
+      {
+      public:
+        explicit Span(StaticName name) : name(name.value), start(enabled() ? nowNs() : 0) {}
+        ~Span()
+        {
+          if (start != 0)
+            record(name, start, nowNs());
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+      private:
+        const char *name;
+        uint64_t start;
+      };
+
+    }
+  }
+}
+
+#define IMAGETUI_TRACE_JOIN_(a, b) a##b
+#define IMAGETUI_TRACE_JOIN(a, b) IMAGETUI_TRACE_JOIN_(a, b)
+
+// Times the enclosing scope. Compiles to nothing unless IMAGETUI_TRACING is set.
+#ifdef IMAGETUI_TRACING
+#define IMAGETUI_TRACE_SCOPE(name) \
+  ::imagetui::utils::trace::Span IMAGETUI_TRACE_JOIN(imagetuiTraceSpan, __LINE__)(name)
+#else
+#define IMAGETUI_TRACE_SCOPE(name) ((void)0)
+#endif
@@ -58,6 +58,7 @@ if [ $# -eq 0 ]; then
     echo "  No arguments provided. Usage:"
     echo "   $0 <input_image> <output_image>"
     echo "   Example: $0 test.jpg output.png"
+    echo "   $0 --batch <input_dir> <output_dir> [--filter sepia,oil:5:20]"
     echo ""
     echo "Available options:"
     echo "   $0 --build          Force rebuild before running"
@@ -0,0 +1,258 @@
+#include "core/batch_processor.h"
+#include "core/bounded_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      struct Frame
+      {
+        std::string outputPath;
+        std::unique_ptr<ImageData> image;
+        std::optional<CacheKey> cacheKey;
+      };
+
+      using Clock = std::chrono::high_resolution_clock;
+
+      // Busy time of one stage, summed across its worker threads.
+      class StageTimer
+      {
+      public:
+        void add(Clock::time_point start)
+        {
+          auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+          total.fetch_add(ns, std::memory_order_relaxed);
+        }
+
+        double seconds() const { return total.load() / 1e9; }
+
+      private:
+        std::atomic<long long> total{0};
+      };
+
+      int defaultThreads(int requested, int fallback)
+      {
+        return requested > 0 ? requested : std::max(1, fallback);
+      }
+
+      bool isImageFile(const fs::path &path)
+      {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" ||
+               ext == ".webp" || ext == ".tif" || ext == ".tiff";
+      }
+
+      // Runs `count` copies of `body` and calls `onLastExit` once all of them
+      // have returned, which is how each stage closes the queue it feeds.
+      template <typename Body, typename OnExit>
+      void startPool(std::vector<std::thread> &threads, int count, Body body, OnExit onLastExit)
+      {
+        auto remaining = std::make_shared<std::atomic<int>>(count);
+        for (int i = 0; i < count; i++)
+        {
+          threads.emplace_back([body, onLastExit, remaining]
+                               {
+            body();
+            if (remaining->fetch_sub(1) == 1)
+              onLastExit(); });
+        }
+      }
+    }
+
+    std::vector<std::string> BatchProcessor::collectInputs(const std::string &inputDir)
+    {
+      std::vector<std::string> files;
+      std::error_code ec;
+
+      for (fs::recursive_directory_iterator it(inputDir, ec), end; !ec && it != end; it.increment(ec))
+      {
+        if (it->is_regular_file(ec) && isImageFile(it->path()))
+          files.push_back(it->path().string());
+      }
+
+      if (ec)
+        std::cerr << "Error: Could not read directory: " << inputDir << " (" << ec.message() << ")" << std::endl;
+
+      std::sort(files.begin(), files.end());
+      return files;
+    }
+
+    BatchStats BatchProcessor::run(const BatchOptions &options, const Pipeline &pipeline)
+    {
+      BatchStats stats;
+      auto wallStart = Clock::now();
+
+      const std::vector<std::string> inputs = collectInputs(options.inputDir);
+      if (inputs.empty())
+        return stats;
+
+      const int hw = static_cast<int>(std::thread::hardware_concurrency());
+      const int decodeThreads = defaultThreads(options.decodeThreads, hw / 2);
+      const int filterThreads = defaultThreads(options.filterThreads, hw / 4);
+      const int encodeThreads = defaultThreads(options.encodeThreads, hw / 2);
+
+      BoundedQueue<Frame> decoded(options.queueCapacity);
+      BoundedQueue<Frame> filtered(options.queueCapacity);
+
+      std::atomic<size_t> nextInput{0};
+      std::atomic<int> processed{0};
+      std::atomic<int> failed{0};
+      std::atomic<int> cached{0};
+      std::atomic<long long> pixels{0};
+      std::atomic<int> inFlight{0};
+      std::atomic<int> peakInFlight{0};
+      StageTimer decodeTime, filterTime, encodeTime;
+
+      auto retire = [&]
+      { inFlight.fetch_sub(1); };
+      auto track = [&](int frames)
+      {
+        int live = inFlight.fetch_add(frames) + frames;
+        int peak = peakInFlight.load();
+        while (live > peak && !peakInFlight.compare_exchange_weak(peak, live))
+        {
+        }
+      };
+
+      std::vector<std::thread> threads;
+
+      startPool(
+          threads, decodeThreads,
+          [&]
+          {
+            for (size_t i = nextInput.fetch_add(1); i < inputs.size(); i = nextInput.fetch_add(1))
+            {
+              fs::path input(inputs[i]);
+              fs::path output = fs::path(options.outputDir) / fs::relative(input, options.inputDir);
+              if (!options.outputFormat.empty())
+                output.replace_extension("." + options.outputFormat);
+
+              auto start = Clock::now();
+              std::optional<CacheKey> inputKey, resultKey;
+
+              if (options.cache && (inputKey = ResultCache::inputKey(input.string())))
+              {
+                resultKey = ResultCache::resultKey(*inputKey, options.chainKey,
+                                                   ResultCache::encoderSignature(output.string(), options.encode));
+
+                std::error_code ec;
+                fs::create_directories(output.parent_path(), ec);
+                uint64_t hitPixels = 0;
+                if (options.cache->fetch(*resultKey, output.string(), &hitPixels))
+                {
+                  decodeTime.add(start);
+                  processed.fetch_add(1);
+                  cached.fetch_add(1);
+                  pixels.fetch_add(static_cast<long long>(hitPixels));
+                  continue;
+                }
+              }
+
+              auto image = options.load ? options.load(input.string()) : ImageProcessor::loadImage(input.string());
+              decodeTime.add(start);
+
+              if (!image)
+              {
+                failed.fetch_add(1);
+                continue;
+              }
+
+              track(1);
+              if (!decoded.push(Frame{output.string(), std::move(image), resultKey}))
+                retire();
+            }
+          },
+          [&]
+          { decoded.close(); });
+
+      startPool(
+          threads, filterThreads,
+          [&]
+          {
+            while (auto frame = decoded.pop())
+            {
+              // The result and any scratch frame live beside the input until
+              // the input is dropped below.
+              const int working = 1 + pipeline.scratchFrames();
+              track(working);
+              auto start = Clock::now();
+              auto result = pipeline.run(*frame->image);
+              filterTime.add(start);
+              inFlight.fetch_sub(working);
+
+              if (!result)
+              {
+                failed.fetch_add(1);
+                retire();
+                continue;
+              }
+
+              frame->image = std::move(result);
+              if (!filtered.push(std::move(*frame)))
+                retire();
+            }
+          },
+          [&]
+          { filtered.close(); });
+
+      startPool(
+          threads, encodeThreads,
+          [&]
+          {
+            while (auto frame = filtered.pop())
+            {
+              std::error_code ec;
+              fs::create_directories(fs::path(frame->outputPath).parent_path(), ec);
+
+              auto start = Clock::now();
+              bool ok = ImageProcessor::saveImage(frame->outputPath, *frame->image, options.encode);
+              encodeTime.add(start);
+
+              if (ok)
+              {
+                if (frame->cacheKey)
+                  options.cache->store(*frame->cacheKey, frame->outputPath, frame->image->getMat().total());
+                processed.fetch_add(1);
+                pixels.fetch_add(1LL * frame->image->width() * frame->image->height());
+              }
+              else
+              {
+                failed.fetch_add(1);
+              }
+
+              frame->image.reset();
+              retire();
+            }
+          },
+          [] {});
+
+      for (auto &thread : threads)
+        thread.join();
+
+      stats.processed = processed.load();
+      stats.failed = failed.load();
+      stats.cached = cached.load();
+      stats.megapixels = pixels.load() / 1e6;
+      stats.wallSeconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+      stats.decodeSeconds = decodeTime.seconds();
+      stats.filterSeconds = filterTime.seconds();
+      stats.encodeSeconds = encodeTime.seconds();
+      stats.peakFramesInFlight = peakInFlight.load();
+      return stats;
+    }
+
+  }
+}
@@ -0,0 +1,168 @@
+#include "core/buffer_pool.h"
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      // Small buffers are cheap for malloc and not worth pooling.
+      constexpr size_t kMinPooledBytes = 64 * 1024;
+      // Classes are spaced an eighth of a power of two apart, so a buffer is
+      // never more than 12.5% larger than what was asked for.
+      constexpr int kClassesPerDoubling = 8;
+    }
+
+    BufferPool &BufferPool::instance()
+    {
+      static BufferPool pool;
+      return pool;
+    }
+
+    void BufferPool::create(cv::Mat &mat, int rows, int cols, int type)
+    {
+      if (mat.empty())
+        mat.allocator = &instance();
+      mat.create(rows, cols, type);
+    }
+
+    void BufferPool::setMaxRetainedBytes(size_t bytes)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxRetainedBytes = bytes;
+      }
+      if (stats().retainedBytes > bytes)
+        trim();
+    }
+
+    void BufferPool::trim()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto &[size, list] : freeLists)
+      {
+        for (void *ptr : list)
+          cv::fastFree(ptr);
+        counters.retainedBytes -= size * list.size();
+        list.clear();
+      }
+    }
+
+    BufferPool::Stats BufferPool::stats() const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return counters;
+    }
+
+    size_t BufferPool::sizeClass(size_t bytes)
+    {
+      if (bytes < kMinPooledBytes)
+        return bytes;
+
+      size_t power = kMinPooledBytes;
+      while (power * 2 <= bytes)
+        power *= 2;
+
+      size_t step = power / kClassesPerDoubling;
+      return (bytes + step - 1) / step * step;
+    }
+
+    void *BufferPool::acquire(size_t bytes) const
+    {
+      size_t size = sizeClass(bytes);
+      if (size < kMinPooledBytes)
+        return cv::fastMalloc(size);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.outstandingBytes += size;
+
+        auto it = freeLists.find(size);
+        if (it != freeLists.end() && !it->second.empty())
+        {
+          void *ptr = it->second.back();
+          it->second.pop_back();
+          counters.retainedBytes -= size;
+          counters.hits++;
+          return ptr;
+        }
+        counters.misses++;
+      }
+
+      return cv::fastMalloc(size);
+    }
+
+    void BufferPool::release(void *ptr, size_t bytes) const
+    {
+      size_t size = sizeClass(bytes);
+      if (size >= kMinPooledBytes)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.outstandingBytes -= size;
+
+        if (counters.retainedBytes + size <= maxRetainedBytes)
+        {
+          freeLists[size].push_back(ptr);
+          counters.retainedBytes += size;
+          return;
+        }
+      }
+
+      cv::fastFree(ptr);
+    }
+
+    // Mirrors cv::StdMatAllocator, but takes and returns memory through the pool.
+    cv::UMatData *BufferPool::allocate(int dims, const int *sizes, int type, void *data0, size_t *step,
+                                       cv::AccessFlag, cv::UMatUsageFlags) const
+    {
+      size_t total = CV_ELEM_SIZE(type);
+      for (int i = dims - 1; i >= 0; i--)
+      {
+        if (step)
+        {
+          if (data0 && step[i] != CV_AUTOSTEP)
+          {
+            CV_Assert(total <= step[i]);
+            total = step[i];
+          }
+          else
+          {
+            step[i] = total;
+          }
+        }
+        total *= sizes[i];
+      }
+
+      uchar *data = data0 ? static_cast<uchar *>(data0) : static_cast<uchar *>(acquire(total));
+      cv::UMatData *u = new cv::UMatData(this);
+      u->data = u->origdata = data;
+      u->size = total;
+      if (data0)
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+
+      return u;
+    }
+
+    bool BufferPool::allocate(cv::UMatData *data, cv::AccessFlag, cv::UMatUsageFlags) const
+    {
+      return data != nullptr;
+    }
+
+    void BufferPool::deallocate(cv::UMatData *u) const
+    {
+      if (!u)
+        return;
+
+      CV_Assert(u->urefcount == 0);
+      CV_Assert(u->refcount == 0);
+      if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+      {
+        release(u->origdata, u->size);
+        u->origdata = nullptr;
+      }
+      delete u;
+    }
+
+  }
+}
@@ -0,0 +1,434 @@
+#include "core/encoder_policy.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "stb_image_write.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      using Clock = std::chrono::high_resolution_clock;
+
+      constexpr int kPngLevels[] = {0, 1, 3, 6, 9};
+      constexpr int kStatRows = 64;
+      constexpr int kMaxQualitySteps = 5;
+
+      // Single-thread megapixels per second before anything has been measured.
+      const std::map<std::string, double> kDefaultThroughput = {
+          {"png0", 250.0}, {"png1", 70.0}, {"png3", 45.0}, {"png6", 18.0}, {"png9", 6.0},
+          {"jpg", 140.0}, {"jpg+opt", 110.0}, {"jpg+prog", 45.0},
+          {"webp", 12.0}, {"webp+lossless", 3.0},
+          {"stb:png", 8.0}, {"stb:jpg", 50.0}, {"stb:bmp", 800.0}, {"stb:tga", 800.0},
+      };
+      constexpr double kUnknownThroughput = 300.0;
+
+      std::mutex throughputMutex;
+      std::map<std::string, double> learnedThroughput;
+
+      std::string extensionOf(const std::string &filename)
+      {
+        std::string ext = filename.substr(filename.find_last_of('.') + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == "jpeg" ? "jpg" : ext;
+      }
+
+      bool isLossy(const std::string &format)
+      {
+        return format == "jpg" || format == "webp";
+      }
+
+      int paramValue(const std::vector<int> &params, int key, int fallback)
+      {
+        for (size_t i = 0; i + 1 < params.size(); i += 2)
+        {
+          if (params[i] == key)
+            return params[i + 1];
+        }
+        return fallback;
+      }
+
+      void setParam(std::vector<int> &params, int key, int value)
+      {
+        for (size_t i = 0; i + 1 < params.size(); i += 2)
+        {
+          if (params[i] == key)
+          {
+            params[i + 1] = value;
+            return;
+          }
+        }
+        params.push_back(key);
+        params.push_back(value);
+      }
+
+      // Names the throughput-table entry an encode is timed under.
+      std::string costKey(const EncodePlan &plan)
+      {
+        if (plan.backend == EncoderBackend::Stb)
+          return "stb:" + plan.format;
+        if (plan.format == "png")
+          return "png" + std::to_string(paramValue(plan.params, cv::IMWRITE_PNG_COMPRESSION, 1));
+        if (plan.format == "jpg")
+        {
+          if (paramValue(plan.params, cv::IMWRITE_JPEG_PROGRESSIVE, 0))
+            return "jpg+prog";
+          return paramValue(plan.params, cv::IMWRITE_JPEG_OPTIMIZE, 0) ? "jpg+opt" : "jpg";
+        }
+        if (plan.format == "webp")
+          return plan.quality > 100 ? "webp+lossless" : "webp";
+        return plan.format;
+      }
+
+      // Lossless size from residual entropy; zlib beats order-0 entropy on
+      // runs, and its faster levels give some of that back.
+      size_t predictLosslessBytes(size_t rawBytes, const ContentStats &stats, int level)
+      {
+        if (level == 0)
+          return rawBytes;
+
+        double ratio = stats.residualEntropy / 8.0 * (1.0 - 0.7 * stats.flatness);
+        double levelPenalty = level >= 6 ? 1.0 : level >= 3 ? 1.08 : 1.2;
+        return std::min(rawBytes, static_cast<size_t>(rawBytes * ratio * levelPenalty) + 1024);
+      }
+
+      // Rough bits per pixel for lossy output; only seeds the quality search.
+      size_t predictLossyBytes(double pixels, const ContentStats &stats, int quality)
+      {
+        double q = std::clamp(quality, 1, 100) / 100.0;
+        double bitsPerPixel = (0.3 + 3.0 * q * q * q * q) * (0.25 + 1.5 * stats.residualEntropy / 8.0);
+        return static_cast<size_t>(pixels * bitsPerPixel / 8.0) + 512;
+      }
+
+      // Writes beside the final name and renames, so a failed or short write
+      // never leaves a truncated image under `filename`.
+      bool writeFile(const std::string &filename, const std::vector<uchar> &bytes)
+      {
+#ifdef _WIN32
+        const long pid = _getpid();
+#else
+        const long pid = static_cast<long>(getpid());
+#endif
+        std::ostringstream tmp;
+        tmp << filename << ".tmp." << pid << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        std::ofstream out(tmp.str(), std::ios::binary);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        out.close();
+
+        std::error_code ec;
+        if (out)
+          std::filesystem::rename(tmp.str(), filename, ec);
+        if (!out || ec)
+        {
+          std::filesystem::remove(tmp.str(), ec);
+          return false;
+        }
+        return true;
+      }
+
+      void appendBytes(void *context, void *data, int size)
+      {
+        auto *bytes = static_cast<std::vector<uchar> *>(context);
+        const uchar *begin = static_cast<const uchar *>(data);
+        bytes->insert(bytes->end(), begin, begin + size);
+      }
+    }
+
+    EncodeBudget EncodeBudget::fastest()
+    {
+      EncodeBudget budget;
+      budget.maxEncodeMs = 1e-6;
+      budget.quality = 95;
+      budget.webpQuality = 90;
+      return budget;
+    }
+
+    ContentStats ContentStats::measure(const cv::Mat &image)
+    {
+      ContentStats stats;
+      if (image.empty() || image.depth() != CV_8U || image.cols < 2)
+        return stats;
+
+      const int channels = image.channels();
+      const int step = std::max(1, image.rows / kStatRows);
+      size_t histogram[256] = {};
+      size_t samples = 0;
+      size_t flat = 0;
+
+      for (int y = 0; y < image.rows; y += step)
+      {
+        const uchar *row = image.ptr<uchar>(y);
+        for (int x = 1; x < image.cols; x++)
+        {
+          const uchar *pixel = row + x * channels;
+          bool same = true;
+          for (int c = 0; c < channels; c++)
+          {
+            uchar residual = static_cast<uchar>(pixel[c] - pixel[c - channels]);
+            histogram[residual]++;
+            same = same && residual == 0;
+          }
+          flat += same;
+          samples++;
+        }
+      }
+
+      const double total = static_cast<double>(samples) * channels;
+      double entropy = 0.0;
+      for (size_t count : histogram)
+      {
+        if (count)
+        {
+          double p = count / total;
+          entropy -= p * std::log2(p);
+        }
+      }
+
+      stats.residualEntropy = entropy;
+      stats.flatness = static_cast<double>(flat) / samples;
+      return stats;
+    }
+
+    EncodePlan EncoderPolicy::choose(const std::string &filename, const cv::Mat &image, const EncodeBudget &budget)
+    {
+      EncodePlan plan;
+      plan.format = extensionOf(filename);
+
+      const double megapixels = image.total() / 1e6;
+      const size_t rawBytes = image.total() * image.elemSize();
+      const bool timeLimited = budget.maxEncodeMs > 0.0;
+      const bool sizeLimited = budget.maxBytes > 0;
+      auto fitsTime = [&](double ms)
+      { return !timeLimited || ms <= budget.maxEncodeMs; };
+      auto predictMs = [&]
+      { return megapixels / throughput(costKey(plan)) * 1000.0; };
+
+      // OpenCV has no TGA writer and may be built without some codecs.
+      const bool stbFormat = plan.format == "png" || plan.format == "jpg" || plan.format == "bmp" ||
+                             plan.format == "tga";
+      if (stbFormat && (plan.format == "tga" || !cv::haveImageWriter(filename)))
+      {
+        plan.backend = EncoderBackend::Stb;
+        plan.quality = plan.format == "jpg" ? std::clamp(std::max(budget.quality, budget.minQuality), 1, 100) : 0;
+        plan.predictedMs = predictMs();
+        plan.predictedBytes = plan.format == "jpg" ? predictLossyBytes(image.total(), ContentStats::measure(image), plan.quality)
+                                                   : rawBytes;
+        return plan;
+      }
+
+      if (plan.format == "png")
+      {
+        const ContentStats stats = ContentStats::measure(image);
+
+        // Without limits store uncompressed below quality 80 and otherwise
+        // stay on the cheap level that already gets most of the gain; with
+        // limits take the cheapest level that meets the size target, or the
+        // strongest one the time limit allows.
+        int chosen = budget.quality > 80 ? 1 : 0;
+        if (timeLimited || sizeLimited)
+        {
+          chosen = 0;
+          for (int level : kPngLevels)
+          {
+            plan.params = {cv::IMWRITE_PNG_COMPRESSION, level};
+            if (!fitsTime(predictMs()))
+              break;
+            chosen = level;
+            if (sizeLimited && predictLosslessBytes(rawBytes, stats, level) <= budget.maxBytes)
+              break;
+          }
+        }
+
+        plan.params = {cv::IMWRITE_PNG_COMPRESSION, chosen};
+        if (chosen > 0)
+        {
+          // Long runs (screenshots, flat synthetic art) favour run-length
+          // matching; noisy photographic rows favour filtered deflate.
+          int strategy = stats.flatness > 0.6         ? cv::IMWRITE_PNG_STRATEGY_RLE
+                         : stats.residualEntropy > 4.0 ? cv::IMWRITE_PNG_STRATEGY_FILTERED
+                                                       : cv::IMWRITE_PNG_STRATEGY_DEFAULT;
+          setParam(plan.params, cv::IMWRITE_PNG_STRATEGY, strategy);
+        }
+        plan.predictedBytes = predictLosslessBytes(rawBytes, stats, chosen);
+      }
+      else if (plan.format == "jpg")
+      {
+        const ContentStats stats = ContentStats::measure(image);
+        plan.quality = std::clamp(std::max(budget.quality, budget.minQuality), 0, 100);
+        plan.params = {cv::IMWRITE_JPEG_QUALITY, plan.quality, cv::IMWRITE_JPEG_OPTIMIZE, 0};
+
+        // Optimized Huffman tables cost one extra pass and save a few percent;
+        // progressive saves a little more at about twice the time, so it is
+        // only worth it when the caller asked for smaller files.
+        setParam(plan.params, cv::IMWRITE_JPEG_OPTIMIZE, 1);
+        if (!fitsTime(predictMs()))
+          setParam(plan.params, cv::IMWRITE_JPEG_OPTIMIZE, 0);
+        else if (sizeLimited && megapixels >= 0.5)
+        {
+          setParam(plan.params, cv::IMWRITE_JPEG_PROGRESSIVE, 1);
+          if (!fitsTime(predictMs()))
+            setParam(plan.params, cv::IMWRITE_JPEG_PROGRESSIVE, 0);
+        }
+
+        plan.predictedBytes = predictLossyBytes(image.total(), stats, plan.quality);
+      }
+      else if (plan.format == "webp")
+      {
+        const ContentStats stats = ContentStats::measure(image);
+        const int quality = budget.webpQuality > 0 ? budget.webpQuality : budget.quality;
+        plan.quality = std::clamp(std::max(quality, budget.minQuality), 1, 100);
+
+        // Flat synthetic content at high quality is smaller lossless. OpenCV
+        // exposes no WebP method/effort setting, only quality (>100 = lossless).
+        if (stats.flatness > 0.6 && plan.quality >= 90)
+        {
+          EncodePlan lossless = plan;
+          lossless.quality = 101;
+          size_t bytes = predictLosslessBytes(rawBytes, stats, 9);
+          if (fitsTime(megapixels / throughput(costKey(lossless)) * 1000.0) &&
+              (!sizeLimited || bytes <= budget.maxBytes))
+          {
+            plan.quality = 101;
+            plan.predictedBytes = bytes;
+          }
+        }
+
+        plan.params = {cv::IMWRITE_WEBP_QUALITY, plan.quality};
+        if (plan.quality <= 100)
+          plan.predictedBytes = predictLossyBytes(image.total(), stats, plan.quality);
+      }
+      else
+      {
+        plan.predictedBytes = rawBytes;
+      }
+
+      plan.predictedMs = predictMs();
+      return plan;
+    }
+
+    bool EncoderPolicy::encode(const std::string &filename, const cv::Mat &image, const EncodePlan &plan,
+                               const EncodeBudget &budget)
+    {
+      EncodePlan attempt = plan;
+      std::vector<uchar> bytes;
+      double spentMs = 0.0;
+
+      for (int step = 0;; step++)
+      {
+        auto start = Clock::now();
+        if (!encodeToMemory(image, attempt, bytes))
+          return false;
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        observe(costKey(attempt), image.total() / 1e6, ms);
+        spentMs += ms;
+
+        const int floor = std::max(1, budget.minQuality);
+        bool over = budget.maxBytes > 0 && bytes.size() > budget.maxBytes;
+        bool canRetry = isLossy(attempt.format) && attempt.quality > floor && attempt.quality <= 100 &&
+                        step + 1 < kMaxQualitySteps &&
+                        (budget.maxEncodeMs <= 0.0 || spentMs + ms <= budget.maxEncodeMs);
+        if (!over || !canRetry)
+          break;
+
+        // Size falls off roughly with the square of quality near the top.
+        double scale = std::sqrt(static_cast<double>(budget.maxBytes) / bytes.size());
+        int next = std::min(attempt.quality - 5, static_cast<int>(attempt.quality * scale));
+        attempt.quality = std::max(floor, next);
+        setParam(attempt.params, attempt.format == "jpg" ? cv::IMWRITE_JPEG_QUALITY : cv::IMWRITE_WEBP_QUALITY,
+                 attempt.quality);
+      }
+
+      return writeFile(filename, bytes);
+    }
+
+    bool EncoderPolicy::encodeToMemory(const cv::Mat &image, const EncodePlan &plan, std::vector<uchar> &bytes)
+    {
+      bytes.clear();
+
+      if (plan.backend == EncoderBackend::OpenCV)
+        return cv::imencode("." + plan.format, image, bytes, plan.params);
+
+      // stb takes RGB(A) order and at most 4 channels of 8-bit data.
+      if (image.depth() != CV_8U || image.channels() > 4 || image.channels() == 2)
+        return false;
+
+      cv::Mat rgb;
+      if (image.channels() == 3)
+        cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+      else if (image.channels() == 4)
+        cv::cvtColor(image, rgb, cv::COLOR_BGRA2RGBA);
+      else
+        rgb = image.isContinuous() ? image : image.clone();
+
+      const int w = rgb.cols, h = rgb.rows, comp = rgb.channels();
+      int ok = 0;
+      if (plan.format == "png")
+        ok = stbi_write_png_to_func(appendBytes, &bytes, w, h, comp, rgb.data, static_cast<int>(rgb.step));
+      else if (plan.format == "jpg")
+        ok = stbi_write_jpg_to_func(appendBytes, &bytes, w, h, comp, rgb.data, plan.quality);
+      else if (plan.format == "bmp")
+        ok = stbi_write_bmp_to_func(appendBytes, &bytes, w, h, comp, rgb.data);
+      else if (plan.format == "tga")
+        ok = stbi_write_tga_to_func(appendBytes, &bytes, w, h, comp, rgb.data);
+
+      return ok != 0;
+    }
+
+    double EncoderPolicy::throughput(const std::string &key)
+    {
+      std::lock_guard<std::mutex> lock(throughputMutex);
+      auto learned = learnedThroughput.find(key);
+      if (learned != learnedThroughput.end())
+        return learned->second;
+
+      auto preset = kDefaultThroughput.find(key);
+      return preset != kDefaultThroughput.end() ? preset->second : kUnknownThroughput;
+    }
+
+    void EncoderPolicy::observe(const std::string &key, double megapixels, double ms)
+    {
+      // Sub-millisecond encodes are mostly fixed overhead and timer noise.
+      if (ms < 1.0)
+        return;
+
+      double measured = megapixels / (ms / 1000.0);
+      std::lock_guard<std::mutex> lock(throughputMutex);
+      auto it = learnedThroughput.find(key);
+      if (it == learnedThroughput.end())
+        learnedThroughput.emplace(key, measured);
+      else
+        it->second = 0.75 * it->second + 0.25 * measured;
+    }
+
+  }
+}
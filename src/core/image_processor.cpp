@@ -1,47 +1,137 @@
 #include "core/image_processor.h"
+#include "core/mapped_file.h"
+#include "utils/utility.h"
 #include <opencv2/imgcodecs.hpp>
-#include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <climits>
 
 namespace imagetui
 {
   namespace core
   {
 
+    namespace
+    {
+      // Reads width and height from a JPEG's start-of-frame segment without
+      // decoding anything.
+      bool jpegSize(const unsigned char *data, size_t size, cv::Size &dims)
+      {
+        if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+          return false;
+
+        size_t pos = 2;
+        while (pos + 4 <= size)
+        {
+          if (data[pos] != 0xFF)
+            return false;
+          const unsigned char marker = data[pos + 1];
+          if (marker == 0xFF)
+          {
+            pos++;
+            continue;
+          }
+          if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+          {
+            pos += 2;
+            continue;
+          }
+
+          const size_t length = (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+          // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC).
+          if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+          {
+            if (pos + 9 > size)
+              return false;
+            dims.height = (data[pos + 5] << 8) | data[pos + 6];
+            dims.width = (data[pos + 7] << 8) | data[pos + 8];
+            return dims.width > 0 && dims.height > 0;
+          }
+          pos += 2 + length;
+        }
+        return false;
+      }
+
+      cv::Mat decode(const std::string &filename, const MappedFile *mapped, int flags)
+      {
+        cv::Mat mat;
+        if (mapped && mapped->size() <= static_cast<size_t>(INT_MAX))
+        {
+          // Decode straight from the mapped pages into a pooled frame; imdecode
+          // allocates through the allocator already set on the destination.
+          cv::Mat encoded(1, static_cast<int>(mapped->size()), CV_8UC1,
+                          const_cast<unsigned char *>(mapped->data()));
+          mat.allocator = &BufferPool::instance();
+          cv::imdecode(encoded, flags, &mat);
+        }
+        else
+        {
+          mat = cv::imread(filename, flags);
+        }
+
+        if (mat.empty())
+          std::cerr << "Error: Could not load image: " << filename << std::endl;
+        return mat;
+      }
+    }
+
     std::unique_ptr<ImageData> ImageProcessor::loadImage(const std::string &filename)
     {
-      cv::Mat mat = cv::imread(filename, cv::IMREAD_COLOR | cv::IMREAD_IGNORE_ORIENTATION);
+      IMAGETUI_TRACE_SCOPE("decode");
 
+      auto mapped = MappedFile::open(filename);
+      cv::Mat mat = decode(filename, mapped.get(), cv::IMREAD_COLOR | cv::IMREAD_IGNORE_ORIENTATION);
       if (mat.empty())
-      {
-        std::cerr << "Error: Could not load image: " << filename << std::endl;
         return nullptr;
-      }
 
       return std::make_unique<ImageData>(std::move(mat));
     }
 
-    bool ImageProcessor::saveImageFast(const std::string &filename, const ImageData &image, int quality)
+    std::unique_ptr<ImageData> ImageProcessor::loadImageReduced(const std::string &filename, cv::Size bounds)
     {
-      if (!image.isValid())
+      IMAGETUI_TRACE_SCOPE("decode");
+
+      auto mapped = MappedFile::open(filename);
+      int flags = cv::IMREAD_COLOR;
+
+      cv::Size full;
+      if (mapped && jpegSize(mapped->data(), mapped->size(), full))
       {
-        std::cerr << "Error: Invalid image data" << std::endl;
-        return false;
+        // libjpeg scales by 1/8 steps in the DCT, rounding sizes up.
+        const cv::Size target = fitWithin(full, bounds);
+        const std::pair<int, int> scales[] = {{8, cv::IMREAD_REDUCED_COLOR_8},
+                                              {4, cv::IMREAD_REDUCED_COLOR_4},
+                                              {2, cv::IMREAD_REDUCED_COLOR_2}};
+        for (const auto &[factor, reduced] : scales)
+        {
+          if ((full.width + factor - 1) / factor >= target.width && (full.height + factor - 1) / factor >= target.height)
+          {
+            flags = reduced;
+            break;
+          }
+        }
       }
 
-      auto params = getCompressionParams(filename, quality);
+      cv::Mat mat = decode(filename, mapped.get(), flags | cv::IMREAD_IGNORE_ORIENTATION);
+      if (mat.empty())
+        return nullptr;
 
-      bool success = cv::imwrite(filename, image.getMat(), params);
+      return std::make_unique<ImageData>(std::move(mat));
+    }
 
-      if (!success)
-      {
-        std::cerr << "Error: Could not save image: " << filename << std::endl;
-      }
+    cv::Size ImageProcessor::fitWithin(cv::Size size, cv::Size bounds)
+    {
+      if (size.width <= bounds.width && size.height <= bounds.height)
+        return size;
 
-      return success;
+      const double scale = std::min(static_cast<double>(bounds.width) / size.width,
+                                    static_cast<double>(bounds.height) / size.height);
+      return cv::Size(std::max(1, static_cast<int>(std::lround(size.width * scale))),
+                      std::max(1, static_cast<int>(std::lround(size.height * scale))));
     }
 
-    bool ImageProcessor::saveImageUltraFast(const std::string &filename, const ImageData &image)
+    bool ImageProcessor::saveImage(const std::string &filename, const ImageData &image, const EncodeBudget &budget)
     {
       if (!image.isValid())
       {
@@ -49,9 +139,10 @@ namespace imagetui
         return false;
       }
 
-      auto params = getUltraFastParams(filename);
+      IMAGETUI_TRACE_SCOPE("encode");
 
-      bool success = cv::imwrite(filename, image.getMat(), params);
+      EncodePlan plan = EncoderPolicy::choose(filename, image.getMat(), budget);
+      bool success = EncoderPolicy::encode(filename, image.getMat(), plan, budget);
 
       if (!success)
       {
@@ -61,57 +152,16 @@ namespace imagetui
       return success;
     }
 
-    std::vector<int> ImageProcessor::getCompressionParams(const std::string &filename, int quality)
+    bool ImageProcessor::saveImageFast(const std::string &filename, const ImageData &image, int quality)
     {
-      std::string ext = filename.substr(filename.find_last_of('.') + 1);
-      std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-      if (ext == "jpg" || ext == "jpeg")
-      {
-        return {cv::IMWRITE_JPEG_QUALITY, std::clamp(quality, 0, 100),
-                cv::IMWRITE_JPEG_OPTIMIZE, 1};
-      }
-      else if (ext == "png")
-      {
-        int compression = (quality > 80) ? 1 : 0;
-        return {cv::IMWRITE_PNG_COMPRESSION, compression};
-      }
-      else if (ext == "webp")
-      {
-        return {cv::IMWRITE_WEBP_QUALITY, std::clamp(quality, 1, 100)};
-      }
-      else if (ext == "bmp")
-      {
-        return {};
-      }
-
-      return {};
+      EncodeBudget budget;
+      budget.quality = quality;
+      return saveImage(filename, image, budget);
     }
 
-    std::vector<int> ImageProcessor::getUltraFastParams(const std::string &filename)
+    bool ImageProcessor::saveImageUltraFast(const std::string &filename, const ImageData &image)
     {
-      std::string ext = filename.substr(filename.find_last_of('.') + 1);
-      std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-      if (ext == "jpg" || ext == "jpeg")
-      {
-        return {cv::IMWRITE_JPEG_QUALITY, 95, cv::IMWRITE_JPEG_OPTIMIZE, 0};
-      }
-      else if (ext == "png")
-      {
-        return {cv::IMWRITE_PNG_COMPRESSION, 0};
-      }
-      else if (ext == "webp")
-      {
-
-        return {cv::IMWRITE_WEBP_QUALITY, 90};
-      }
-      else if (ext == "bmp")
-      {
-        return {};
-      }
-
-      return {};
+      return saveImage(filename, image, EncodeBudget::fastest());
     }
 
   }
@@ -0,0 +1,103 @@
+#include "core/mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace imagetui
+{
+  namespace core
+  {
+
+#ifdef _WIN32
+
+    std::unique_ptr<MappedFile> MappedFile::open(const std::string &filename)
+    {
+      HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+      {
+        CloseHandle(file);
+        return nullptr;
+      }
+
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+      if (!view)
+      {
+        if (mapping)
+          CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+      }
+
+      std::unique_ptr<MappedFile> mapped(new MappedFile());
+      mapped->bytes = static_cast<const unsigned char *>(view);
+      mapped->length = static_cast<size_t>(size.QuadPart);
+      mapped->fileHandle = file;
+      mapped->mappingHandle = mapping;
+      return mapped;
+    }
+
+    MappedFile::~MappedFile()
+    {
+      if (bytes)
+        UnmapViewOfFile(bytes);
+      if (mappingHandle)
+        CloseHandle(mappingHandle);
+      if (fileHandle)
+        CloseHandle(fileHandle);
+    }
+
+#else
+
+    std::unique_ptr<MappedFile> MappedFile::open(const std::string &filename)
+    {
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if (fd < 0)
+        return nullptr;
+
+      struct stat info;
+      if (fstat(fd, &info) != 0 || info.st_size <= 0)
+      {
+        ::close(fd);
+        return nullptr;
+      }
+
+      size_t length = static_cast<size_t>(info.st_size);
+      void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      // The mapping keeps its own reference to the file.
+      ::close(fd);
+
+      if (view == MAP_FAILED)
+        return nullptr;
+
+      // Decoders read front to back; let the kernel read ahead aggressively.
+      madvise(view, length, MADV_SEQUENTIAL);
+
+      std::unique_ptr<MappedFile> mapped(new MappedFile());
+      mapped->bytes = static_cast<const unsigned char *>(view);
+      mapped->length = length;
+      return mapped;
+    }
+
+    MappedFile::~MappedFile()
+    {
+      if (bytes)
+        munmap(const_cast<unsigned char *>(bytes), length);
+    }
+
+#endif
+
+  }
+}
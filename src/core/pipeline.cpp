@@ -0,0 +1,136 @@
+#include "core/pipeline.h"
+#include "utils/utility.h"
+#include <algorithm>
+#include <cstring>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      // Rows per tile are picked so a tile stays L2-resident while every fused
+      // op runs over it.
+      constexpr size_t kTileBytes = 256 * 1024;
+    }
+
+    Pipeline &Pipeline::then(PointOp op)
+    {
+      if (segments.empty())
+        segments.emplace_back();
+
+      segments.back().points.push_back(std::move(op));
+      return *this;
+    }
+
+    Pipeline &Pipeline::thenNeighborhood(NeighborhoodOp op, int halo)
+    {
+      Segment segment;
+      segment.gather = std::move(op);
+      segment.halo = std::max(0, halo);
+      segments.push_back(std::move(segment));
+      return *this;
+    }
+
+    int Pipeline::halo() const
+    {
+      int total = 0;
+      for (const auto &segment : segments)
+        total += segment.halo;
+      return total;
+    }
+
+    std::unique_ptr<ImageData> Pipeline::run(const ImageData &input, const CancelToken *cancel) const
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      const cv::Mat &src = input.getMat();
+      auto output = std::make_unique<ImageData>(src.cols, src.rows, src.type());
+
+      if (!runStrip(src, output->getMat(), 0, src.size(), cancel))
+        return nullptr;
+
+      return output;
+    }
+
+    bool Pipeline::runStrip(const cv::Mat &src, cv::Mat &dst, int yOffset, cv::Size imageSize,
+                            const CancelToken *cancel) const
+    {
+      IMAGETUI_TRACE_SCOPE("filter");
+
+      BufferPool::create(dst, src.rows, src.cols, src.type());
+
+      if (segments.empty())
+      {
+        src.copyTo(dst);
+        return true;
+      }
+
+      // Segments alternate between dst and a single scratch frame, counted back
+      // from the last one so that the final segment always lands in dst.
+      cv::Mat scratch;
+      const cv::Mat *current = &src;
+      const size_t count = segments.size();
+
+      for (size_t i = 0; i < count; i++)
+      {
+        bool toDst = ((count - 1 - i) % 2) == 0;
+        if (!toDst && scratch.empty())
+          BufferPool::create(scratch, src.rows, src.cols, src.type());
+
+        cv::Mat &target = toDst ? dst : scratch;
+        if (!runSegment(segments[i], *current, target, yOffset, imageSize, cancel))
+          return false;
+        current = &target;
+      }
+      return true;
+    }
+
+    bool Pipeline::runSegment(const Segment &segment, const cv::Mat &src, cv::Mat &dst,
+                              int yOffset, cv::Size imageSize, const CancelToken *cancel)
+    {
+      // Neighborhood tiles re-read 2 * halo rows, so keep them tall enough for
+      // that overlap to stay small.
+      const int rowsPerTile = std::max(tileRows(src), std::min(src.rows, 4 * segment.halo));
+      const int tiles = (src.rows + rowsPerTile - 1) / rowsPerTile;
+      const int width = src.cols;
+      const int channels = src.channels();
+      const size_t rowBytes = static_cast<size_t>(width) * src.elemSize();
+
+      cv::parallel_for_(cv::Range(0, tiles), [&](const cv::Range &range)
+                        {
+        for (int t = range.start; t < range.end; t++) {
+          if (cancel && cancel->load(std::memory_order_relaxed))
+            return;
+
+          IMAGETUI_TRACE_SCOPE("filter.tile");
+          const int y0 = t * rowsPerTile;
+          const int y1 = std::min(src.rows, y0 + rowsPerTile);
+
+          if (segment.gather)
+            segment.gather(src, dst, cv::Range(y0, y1));
+
+          for (int y = y0; y < y1; y++) {
+            uchar *row = dst.ptr<uchar>(y);
+            if (!segment.gather)
+              std::memcpy(row, src.ptr<uchar>(y), rowBytes);
+
+            RowContext ctx{yOffset + y, imageSize};
+            for (const auto &op : segment.points)
+              op(row, width, channels, ctx);
+          }
+        } });
+
+      return !(cancel && cancel->load(std::memory_order_relaxed));
+    }
+
+    int Pipeline::tileRows(const cv::Mat &mat)
+    {
+      size_t rowBytes = std::max<size_t>(1, static_cast<size_t>(mat.cols) * mat.elemSize());
+      return static_cast<int>(std::clamp<size_t>(kTileBytes / rowBytes, 1, static_cast<size_t>(std::max(1, mat.rows))));
+    }
+
+  }
+}
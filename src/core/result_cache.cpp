@@ -0,0 +1,464 @@
+#include "core/result_cache.h"
+#include "core/mapped_file.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      // Bump when filter or encoder output or the entry layout changes without
+      // a version bump, so stale entries stop matching.
+      constexpr int kCacheFormat = 1;
+
+      // Disk entries start with the result's pixel count, so a hit can report
+      // the work it saved without decoding anything.
+      constexpr size_t kEntryHeader = sizeof(uint64_t);
+
+      // Temp files older than this belong to a store that died; younger ones
+      // may still be in progress in another process.
+      constexpr auto kStaleTempAge = std::chrono::hours(1);
+
+      const std::string kTempTag = ".tmp.";
+
+      bool isHexName(const std::string &name, size_t length)
+      {
+        return name.size() == length &&
+               std::all_of(name.begin(), name.end(), [](unsigned char c)
+                           { return std::isdigit(c) || (c >= 'a' && c <= 'f'); });
+      }
+
+      long processId()
+      {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return static_cast<long>(getpid());
+#endif
+      }
+
+      // Encoded results larger than this share of the memory cap stay on disk
+      // only, so one big file cannot flush everything else.
+      constexpr size_t kMemoryEntryShare = 8;
+
+      constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+      constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+      constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+      constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+      constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+      inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+      inline uint64_t read64(const unsigned char *p)
+      {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      inline uint32_t read32(const unsigned char *p)
+      {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      inline uint64_t hashRound(uint64_t acc, uint64_t input)
+      {
+        acc += input * kPrime2;
+        return rotl(acc, 31) * kPrime1;
+      }
+
+      inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+      {
+        acc ^= hashRound(0, value);
+        return acc * kPrime1 + kPrime4;
+      }
+
+      // xxHash64: four independent lanes over 32-byte stripes, which runs
+      // at memory bandwidth and is far cheaper than the decode it saves.
+      uint64_t hash64(const unsigned char *data, size_t size, uint64_t seed)
+      {
+        const unsigned char *p = data;
+        const unsigned char *end = data + size;
+        uint64_t h;
+
+        if (size >= 32)
+        {
+          uint64_t v1 = seed + kPrime1 + kPrime2;
+          uint64_t v2 = seed + kPrime2;
+          uint64_t v3 = seed;
+          uint64_t v4 = seed - kPrime1;
+          for (; p + 32 <= end; p += 32)
+          {
+            v1 = hashRound(v1, read64(p));
+            v2 = hashRound(v2, read64(p + 8));
+            v3 = hashRound(v3, read64(p + 16));
+            v4 = hashRound(v4, read64(p + 24));
+          }
+          h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+          h = mergeRound(h, v1);
+          h = mergeRound(h, v2);
+          h = mergeRound(h, v3);
+          h = mergeRound(h, v4);
+        }
+        else
+        {
+          h = seed + kPrime5;
+        }
+
+        h += size;
+        for (; p + 8 <= end; p += 8)
+          h = rotl(h ^ hashRound(0, read64(p)), 27) * kPrime1 + kPrime4;
+        if (p + 4 <= end)
+        {
+          h = rotl(h ^ (read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+          p += 4;
+        }
+        for (; p < end; p++)
+          h = rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+      }
+
+      bool readFile(const std::string &path, std::vector<uchar> &bytes)
+      {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+          return false;
+
+        bytes.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(in);
+      }
+
+      bool writeFile(const std::string &path, const std::vector<uchar> &bytes)
+      {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+      }
+    }
+
+    std::string CacheKey::name() const
+    {
+      char text[49];
+      std::snprintf(text, sizeof(text), "%016llx%016llx%016llx", static_cast<unsigned long long>(content),
+                    static_cast<unsigned long long>(length), static_cast<unsigned long long>(params));
+      return text;
+    }
+
+    ResultCache::ResultCache(CacheOptions options) : options(std::move(options))
+    {
+      loadIndex();
+    }
+
+    std::optional<CacheKey> ResultCache::inputKey(const std::string &filename)
+    {
+      auto mapped = MappedFile::open(filename);
+      if (!mapped)
+        return std::nullopt;
+
+      CacheKey key;
+      key.content = hash64(mapped->data(), mapped->size(), 0);
+      key.length = mapped->size();
+      return key;
+    }
+
+    CacheKey ResultCache::resultKey(const CacheKey &input, const std::string &chain, const std::string &encoder)
+    {
+      std::string text = std::string(PROJECT_VERSION) + '/' + std::to_string(kCacheFormat) + '\n' + chain + '\n' +
+                         encoder;
+      CacheKey key = input;
+      key.params = std::max<uint64_t>(1, hash64(reinterpret_cast<const unsigned char *>(text.data()), text.size(), 1));
+      return key;
+    }
+
+    std::string ResultCache::encoderSignature(const std::string &outputPath, const EncodeBudget &budget)
+    {
+      std::string ext = fs::path(outputPath).extension().string();
+      std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+      std::ostringstream text;
+      text << ext << ":q" << budget.quality << ":webp" << budget.webpQuality << ":min" << budget.minQuality
+           << ":ms" << budget.maxEncodeMs << ":bytes" << budget.maxBytes;
+      return text.str();
+    }
+
+    bool ResultCache::fetch(const CacheKey &key, const std::string &outputPath, uint64_t *pixels)
+    {
+      const std::string name = key.name();
+      std::shared_ptr<const std::vector<uchar>> bytes;
+      uint64_t entryPixels = 0;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto hit = memoryIndex.find(name);
+        if (hit != memoryIndex.end())
+        {
+          memory.splice(memory.begin(), memory, hit->second);
+          bytes = hit->second->encoded;
+          entryPixels = hit->second->pixels;
+          counters.memoryHits++;
+        }
+        else if (diskIndex.count(name) == 0)
+        {
+          counters.misses++;
+          return false;
+        }
+      }
+
+      if (!bytes)
+      {
+        const std::string source = diskPath(name);
+        std::vector<uchar> data;
+        const bool found = readFile(source, data) && data.size() >= kEntryHeader;
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          auto entry = diskIndex.find(name);
+          if (!found)
+          {
+            // Removed behind our back (another process evicted it).
+            if (entry != diskIndex.end())
+            {
+              counters.diskBytes -= entry->second->bytes;
+              disk.erase(entry->second);
+              diskIndex.erase(entry);
+            }
+            counters.misses++;
+            return false;
+          }
+
+          counters.diskHits++;
+          if (entry != diskIndex.end())
+            disk.splice(disk.begin(), disk, entry->second);
+        }
+        std::error_code ec;
+        fs::last_write_time(source, fs::file_time_type::clock::now(), ec);
+
+        std::memcpy(&entryPixels, data.data(), kEntryHeader);
+        data.erase(data.begin(), data.begin() + kEntryHeader);
+        bytes = std::make_shared<const std::vector<uchar>>(std::move(data));
+
+        // Promote, so the next hit skips the filesystem.
+        if (bytes->size() <= options.maxMemoryBytes / kMemoryEntryShare)
+        {
+          MemoryEntry promoted;
+          promoted.name = name;
+          promoted.encoded = bytes;
+          promoted.pixels = entryPixels;
+          promoted.bytes = bytes->size();
+
+          std::lock_guard<std::mutex> lock(mutex);
+          insertMemory(std::move(promoted));
+        }
+      }
+
+      if (pixels)
+        *pixels = entryPixels;
+      return writeFile(outputPath, *bytes);
+    }
+
+    void ResultCache::store(const CacheKey &key, const std::string &outputPath, uint64_t pixels)
+    {
+      std::vector<uchar> bytes;
+      if (!readFile(outputPath, bytes))
+        return;
+
+      const std::string name = key.name();
+
+      if (!options.directory.empty())
+      {
+        // Write beside the final name and rename, so a reader in another
+        // process never sees a partial entry.
+        const std::string path = diskPath(name);
+        std::ostringstream tmp;
+        tmp << path << kTempTag << processId() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        std::error_code ec;
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        std::vector<uchar> record(kEntryHeader);
+        std::memcpy(record.data(), &pixels, kEntryHeader);
+        record.insert(record.end(), bytes.begin(), bytes.end());
+        if (writeFile(tmp.str(), record))
+        {
+          fs::rename(tmp.str(), path, ec);
+          if (!ec)
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            insertDisk(name, record.size());
+          }
+        }
+        if (ec)
+          fs::remove(tmp.str(), ec);
+      }
+
+      if (bytes.size() <= options.maxMemoryBytes / kMemoryEntryShare)
+      {
+        MemoryEntry entry;
+        entry.name = name;
+        entry.bytes = bytes.size();
+        entry.pixels = pixels;
+        entry.encoded = std::make_shared<const std::vector<uchar>>(std::move(bytes));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        insertMemory(std::move(entry));
+      }
+    }
+
+    CacheStats ResultCache::stats() const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return counters;
+    }
+
+    void ResultCache::loadIndex()
+    {
+      if (options.directory.empty())
+        return;
+
+      std::error_code ec;
+      fs::create_directories(options.directory, ec);
+
+      struct Found
+      {
+        fs::file_time_type time;
+        DiskEntry entry;
+      };
+      std::vector<Found> found;
+
+      // Only files laid out as diskPath() names them are touched, so a cache
+      // pointed at a directory with other contents leaves those alone.
+      const size_t keyLength = CacheKey().name().size();
+      const auto staleBefore = fs::file_time_type::clock::now() - kStaleTempAge;
+      for (fs::directory_iterator dir(options.directory, ec), end; !ec && dir != end; dir.increment(ec))
+      {
+        std::error_code fileError;
+        const std::string prefix = dir->path().filename().string();
+        if (!isHexName(prefix, 2) || !dir->is_directory(fileError))
+          continue;
+
+        std::error_code listError;
+        for (fs::directory_iterator it(dir->path(), listError); !listError && it != end; it.increment(listError))
+        {
+          const std::string name = it->path().filename().string();
+          if (name.compare(0, 2, prefix) != 0 || !isHexName(name.substr(0, keyLength), keyLength) ||
+              !it->is_regular_file(fileError))
+            continue;
+
+          const auto time = it->last_write_time(fileError);
+          if (fileError)
+            continue;
+          if (name.size() == keyLength)
+          {
+            const auto size = it->file_size(fileError);
+            if (!fileError)
+              found.push_back(Found{time, DiskEntry{name, static_cast<size_t>(size)}});
+          }
+          else if (name.compare(keyLength, kTempTag.size(), kTempTag) == 0 && time < staleBefore)
+            fs::remove(it->path(), fileError); // left over from an interrupted store
+        }
+      }
+
+      std::sort(found.begin(), found.end(), [](const Found &a, const Found &b)
+                { return a.time > b.time; });
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto &item : found)
+      {
+        disk.push_back(item.entry);
+        diskIndex[item.entry.name] = std::prev(disk.end());
+        counters.diskBytes += item.entry.bytes;
+      }
+      insertDisk("", 0);
+    }
+
+    void ResultCache::insertMemory(MemoryEntry entry)
+    {
+      if (entry.bytes > options.maxMemoryBytes)
+        return;
+
+      auto existing = memoryIndex.find(entry.name);
+      if (existing != memoryIndex.end())
+      {
+        counters.memoryBytes -= existing->second->bytes;
+        memory.erase(existing->second);
+        memoryIndex.erase(existing);
+      }
+
+      counters.memoryBytes += entry.bytes;
+      memory.push_front(std::move(entry));
+      memoryIndex[memory.front().name] = memory.begin();
+
+      while (counters.memoryBytes > options.maxMemoryBytes && memory.size() > 1)
+      {
+        counters.memoryBytes -= memory.back().bytes;
+        memoryIndex.erase(memory.back().name);
+        memory.pop_back();
+        counters.memoryEvictions++;
+      }
+    }
+
+    // An empty name only trims the cache down to its cap.
+    void ResultCache::insertDisk(const std::string &name, size_t bytes)
+    {
+      if (!name.empty())
+      {
+        auto existing = diskIndex.find(name);
+        if (existing != diskIndex.end())
+        {
+          counters.diskBytes -= existing->second->bytes;
+          disk.erase(existing->second);
+          diskIndex.erase(existing);
+        }
+
+        counters.diskBytes += bytes;
+        disk.push_front(DiskEntry{name, bytes});
+        diskIndex[name] = disk.begin();
+      }
+
+      std::error_code ec;
+      while (counters.diskBytes > options.maxDiskBytes && disk.size() > 1)
+      {
+        fs::remove(diskPath(disk.back().name), ec);
+        counters.diskBytes -= disk.back().bytes;
+        diskIndex.erase(disk.back().name);
+        disk.pop_back();
+        counters.diskEvictions++;
+      }
+    }
+
+    std::string ResultCache::diskPath(const std::string &name) const
+    {
+      // Two-character fan-out keeps directories small.
+      return (fs::path(options.directory) / name.substr(0, 2) / name).string();
+    }
+
+  }
+}
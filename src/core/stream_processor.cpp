@@ -0,0 +1,119 @@
+#include "core/stream_processor.h"
+#include "core/strip_io.h"
+#include "utils/utility.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    bool StreamProcessor::run(const std::string &input, const std::string &output, const Pipeline &pipeline,
+                              const StreamOptions &options, StreamStats *stats)
+    {
+      auto t0 = std::chrono::high_resolution_clock::now();
+
+      auto reader = StripReader::open(input);
+      if (!reader)
+        return false;
+
+      const cv::Size size = reader->size();
+      auto writer = StripWriter::open(output, size, options.quality);
+      if (!writer)
+        return false;
+
+      if (!reader->streaming())
+        std::cerr << "Warning: " << input << " is decoded in full; stream from BMP or PPM to bound memory" << std::endl;
+      if (!writer->streaming())
+        std::cerr << "Warning: " << output << " is buffered in full; write PNG, BMP or PPM to bound memory" << std::endl;
+
+      const int halo = pipeline.halo();
+      const int stripRows = std::max(1, options.stripRows);
+      const size_t rowBytes = static_cast<size_t>(size.width) * 3;
+
+      // The window holds the source rows for the current strip plus halo rows
+      // on each side. Rows still needed by the next strip are shifted to the
+      // front instead of being read again.
+      cv::Mat window;
+      BufferPool::create(window, std::min(size.height, stripRows + 2 * halo), size.width, CV_8UC3);
+      int windowStart = 0;
+      int windowRows = 0;
+      cv::Mat result;
+      int strips = 0;
+      int peakRows = 0;
+
+      for (int y0 = 0; y0 < size.height; y0 += stripRows)
+      {
+        const int y1 = std::min(size.height, y0 + stripRows);
+        const int need0 = std::max(0, y0 - halo);
+        const int need1 = std::min(size.height, y1 + halo);
+
+        const int drop = need0 - windowStart;
+        if (drop > 0)
+        {
+          windowRows -= drop;
+          for (int y = 0; y < windowRows; y++)
+            std::memmove(window.ptr<uchar>(y), window.ptr<uchar>(y + drop), rowBytes);
+          windowStart = need0;
+        }
+
+        const int fresh = need1 - (windowStart + windowRows);
+        if (fresh > 0)
+        {
+          IMAGETUI_TRACE_SCOPE("stream.read");
+          cv::Mat rows = window.rowRange(windowRows, windowRows + fresh);
+          if (!reader->read(rows))
+          {
+            std::cerr << "Error: Could not read rows from: " << input << std::endl;
+            return false;
+          }
+          windowRows += fresh;
+        }
+
+        if (!pipeline.runStrip(window.rowRange(0, windowRows), result, windowStart, size))
+        {
+          std::cerr << "Error: Filtering failed at row " << y0 << " of: " << input << std::endl;
+          return false;
+        }
+        peakRows = std::max(peakRows, windowRows);
+
+        bool written;
+        {
+          IMAGETUI_TRACE_SCOPE("stream.write");
+          written = writer->write(result.rowRange(y0 - windowStart, y1 - windowStart));
+        }
+        if (!written)
+        {
+          std::cerr << "Error: Could not write rows to: " << output << std::endl;
+          return false;
+        }
+        strips++;
+      }
+
+      if (!writer->finish())
+      {
+        std::cerr << "Error: Could not save image: " << output << std::endl;
+        return false;
+      }
+
+      if (stats)
+      {
+        stats->strips = strips;
+        stats->megapixels = 1e-6 * size.width * size.height;
+        stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        // The window, plus the result and any pipeline scratch, each sized to
+        // the largest window filtered.
+        stats->peakStripBytes = (static_cast<size_t>(window.rows) +
+                                 static_cast<size_t>(peakRows) * (1 + pipeline.scratchFrames())) * rowBytes;
+        stats->streamedInput = reader->streaming();
+        stats->streamedOutput = writer->streaming();
+      }
+
+      return true;
+    }
+
+  }
+}
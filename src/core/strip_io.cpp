@@ -0,0 +1,566 @@
+#include "core/strip_io.h"
+#include "core/image_processor.h"
+#include "core/mapped_file.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace imagetui
+{
+  namespace core
+  {
+
+    namespace
+    {
+      std::string extensionOf(const std::string &filename)
+      {
+        std::string ext = filename.substr(filename.find_last_of('.') + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext;
+      }
+
+      uint16_t readLe16(const unsigned char *p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+      uint32_t readLe32(const unsigned char *p)
+      {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+      }
+
+      void putLe16(unsigned char *p, uint16_t v)
+      {
+        p[0] = static_cast<unsigned char>(v);
+        p[1] = static_cast<unsigned char>(v >> 8);
+      }
+      void putLe32(unsigned char *p, uint32_t v)
+      {
+        for (int i = 0; i < 4; i++)
+          p[i] = static_cast<unsigned char>(v >> (8 * i));
+      }
+      void putBe32(unsigned char *p, uint32_t v)
+      {
+        for (int i = 0; i < 4; i++)
+          p[i] = static_cast<unsigned char>(v >> (24 - 8 * i));
+      }
+
+      // ---- Readers ---------------------------------------------------------
+
+      // Uncompressed 24/32-bit BMP, either row order.
+      class BmpReader : public StripReader
+      {
+      public:
+        static std::unique_ptr<StripReader> open(std::unique_ptr<MappedFile> file)
+        {
+          const unsigned char *p = file->data();
+          if (file->size() < 54 || p[0] != 'B' || p[1] != 'M')
+            return nullptr;
+
+          uint32_t offset = readLe32(p + 10);
+          int32_t width = static_cast<int32_t>(readLe32(p + 18));
+          int32_t height = static_cast<int32_t>(readLe32(p + 22));
+          uint16_t bits = readLe16(p + 28);
+          uint32_t compression = readLe32(p + 30);
+
+          // INT32_MIN has no positive counterpart to flip a top-down height to.
+          if (width <= 0 || height == 0 || height == std::numeric_limits<int32_t>::min() ||
+              (bits != 24 && bits != 32) || compression != 0)
+            return nullptr;
+
+          std::unique_ptr<BmpReader> reader(new BmpReader());
+          reader->imageSize = cv::Size(width, height < 0 ? -height : height);
+          reader->bytesPerPixel = bits / 8;
+          reader->stride = (static_cast<size_t>(width) * reader->bytesPerPixel + 3) & ~size_t(3);
+          reader->bottomUp = height > 0;
+          reader->pixels = p + offset;
+
+          if (offset > file->size() ||
+              reader->stride > (file->size() - offset) / static_cast<size_t>(reader->imageSize.height))
+            return nullptr;
+
+          reader->file = std::move(file);
+          return reader;
+        }
+
+        bool read(cv::Mat &rows) override
+        {
+          if (nextRow + rows.rows > imageSize.height)
+            return false;
+
+          for (int y = 0; y < rows.rows; y++, nextRow++)
+          {
+            int fileRow = bottomUp ? imageSize.height - 1 - nextRow : nextRow;
+            const unsigned char *src = pixels + stride * fileRow;
+            unsigned char *dst = rows.ptr<uchar>(y);
+
+            if (bytesPerPixel == 3)
+            {
+              std::memcpy(dst, src, static_cast<size_t>(imageSize.width) * 3);
+            }
+            else
+            {
+              for (int x = 0; x < imageSize.width; x++)
+                std::memcpy(dst + x * 3, src + x * 4, 3);
+            }
+          }
+          return true;
+        }
+
+      private:
+        std::unique_ptr<MappedFile> file;
+        const unsigned char *pixels = nullptr;
+        size_t stride = 0;
+        int bytesPerPixel = 3;
+        bool bottomUp = true;
+        int nextRow = 0;
+      };
+
+      // Binary PPM (P6) and PGM (P5) with maxval 255.
+      class PnmReader : public StripReader
+      {
+      public:
+        static std::unique_ptr<StripReader> open(std::unique_ptr<MappedFile> file)
+        {
+          const unsigned char *p = file->data();
+          const size_t size = file->size();
+          if (size < 2 || p[0] != 'P' || (p[1] != '6' && p[1] != '5'))
+            return nullptr;
+
+          size_t pos = 2;
+          int fields[3];
+          for (int &field : fields)
+          {
+            while (pos < size && (std::isspace(p[pos]) || p[pos] == '#'))
+            {
+              if (p[pos] == '#')
+                while (pos < size && p[pos] != '\n')
+                  pos++;
+              else
+                pos++;
+            }
+
+            int64_t value = 0;
+            bool digits = false;
+            while (pos < size && std::isdigit(p[pos]) && value < (int64_t(1) << 30))
+            {
+              value = value * 10 + (p[pos++] - '0');
+              digits = true;
+            }
+            // The digit loop stops once the value passes 2^30, so a longer
+            // field would otherwise wrap when narrowed to int.
+            if (!digits || value >= (int64_t(1) << 30))
+              return nullptr;
+            field = static_cast<int>(value);
+          }
+          pos++; // single whitespace byte before the raster
+
+          std::unique_ptr<PnmReader> reader(new PnmReader());
+          reader->imageSize = cv::Size(fields[0], fields[1]);
+          reader->channels = p[1] == '6' ? 3 : 1;
+
+          size_t rasterBytes = static_cast<size_t>(fields[0]) * fields[1] * reader->channels;
+          if (fields[0] <= 0 || fields[1] <= 0 || fields[2] != 255 || pos + rasterBytes > size)
+            return nullptr;
+
+          reader->pixels = p + pos;
+          reader->file = std::move(file);
+          return reader;
+        }
+
+        bool read(cv::Mat &rows) override
+        {
+          if (nextRow + rows.rows > imageSize.height)
+            return false;
+
+          const size_t rowBytes = static_cast<size_t>(imageSize.width) * channels;
+          for (int y = 0; y < rows.rows; y++, nextRow++)
+          {
+            const unsigned char *src = pixels + rowBytes * nextRow;
+            unsigned char *dst = rows.ptr<uchar>(y);
+            for (int x = 0; x < imageSize.width; x++)
+            {
+              if (channels == 3)
+              {
+                dst[x * 3 + 0] = src[x * 3 + 2];
+                dst[x * 3 + 1] = src[x * 3 + 1];
+                dst[x * 3 + 2] = src[x * 3 + 0];
+              }
+              else
+              {
+                dst[x * 3 + 0] = dst[x * 3 + 1] = dst[x * 3 + 2] = src[x];
+              }
+            }
+          }
+          return true;
+        }
+
+      private:
+        std::unique_ptr<MappedFile> file;
+        const unsigned char *pixels = nullptr;
+        int channels = 3;
+        int nextRow = 0;
+      };
+
+      // Anything OpenCV can decode, fully decoded up front.
+      class DecodedReader : public StripReader
+      {
+      public:
+        static std::unique_ptr<StripReader> open(const std::string &filename)
+        {
+          auto image = ImageProcessor::loadImage(filename);
+          if (!image)
+            return nullptr;
+
+          std::unique_ptr<DecodedReader> reader(new DecodedReader());
+          reader->imageSize = image->getMat().size();
+          reader->incremental = false;
+          reader->image = std::move(image);
+          return reader;
+        }
+
+        bool read(cv::Mat &rows) override
+        {
+          if (nextRow + rows.rows > imageSize.height)
+            return false;
+
+          image->getMat().rowRange(nextRow, nextRow + rows.rows).copyTo(rows);
+          nextRow += rows.rows;
+          return true;
+        }
+
+      private:
+        std::unique_ptr<ImageData> image;
+        int nextRow = 0;
+      };
+
+      // ---- Writers ---------------------------------------------------------
+
+      class BmpWriter : public StripWriter
+      {
+      public:
+        static std::unique_ptr<StripWriter> open(const std::string &filename, cv::Size size)
+        {
+          const size_t stride = (static_cast<size_t>(size.width) * 3 + 3) & ~size_t(3);
+          const uint64_t fileSize = 54 + static_cast<uint64_t>(stride) * size.height;
+          if (fileSize > UINT32_MAX)
+          {
+            std::cerr << "Error: Image too large for BMP: " << filename << std::endl;
+            return nullptr;
+          }
+
+          std::unique_ptr<BmpWriter> writer(new BmpWriter());
+          writer->out.open(filename, std::ios::binary);
+          if (!writer->out)
+            return nullptr;
+
+          // Negative height marks a top-down bitmap, so rows go out in the
+          // order they arrive.
+          unsigned char header[54] = {'B', 'M'};
+          putLe32(header + 2, static_cast<uint32_t>(fileSize));
+          putLe32(header + 10, 54);
+          putLe32(header + 14, 40);
+          putLe32(header + 18, static_cast<uint32_t>(size.width));
+          putLe32(header + 22, static_cast<uint32_t>(-size.height));
+          putLe16(header + 26, 1);
+          putLe16(header + 28, 24);
+          putLe32(header + 34, static_cast<uint32_t>(stride * size.height));
+          writer->out.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+          writer->row.assign(stride, 0);
+          return writer;
+        }
+
+        bool write(const cv::Mat &rows) override
+        {
+          const size_t bytes = static_cast<size_t>(rows.cols) * 3;
+          for (int y = 0; y < rows.rows; y++)
+          {
+            std::memcpy(row.data(), rows.ptr<uchar>(y), bytes);
+            out.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+          }
+          return static_cast<bool>(out);
+        }
+
+        bool finish() override
+        {
+          out.close();
+          return !out.fail();
+        }
+
+      private:
+        std::ofstream out;
+        std::vector<unsigned char> row;
+      };
+
+      class PpmWriter : public StripWriter
+      {
+      public:
+        static std::unique_ptr<StripWriter> open(const std::string &filename, cv::Size size)
+        {
+          std::unique_ptr<PpmWriter> writer(new PpmWriter());
+          writer->out.open(filename, std::ios::binary);
+          if (!writer->out)
+            return nullptr;
+
+          writer->out << "P6\n"
+                      << size.width << " " << size.height << "\n255\n";
+          writer->row.resize(static_cast<size_t>(size.width) * 3);
+          return writer;
+        }
+
+        bool write(const cv::Mat &rows) override
+        {
+          for (int y = 0; y < rows.rows; y++)
+          {
+            const uchar *src = rows.ptr<uchar>(y);
+            for (int x = 0; x < rows.cols; x++)
+            {
+              row[x * 3 + 0] = src[x * 3 + 2];
+              row[x * 3 + 1] = src[x * 3 + 1];
+              row[x * 3 + 2] = src[x * 3 + 0];
+            }
+            out.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+          }
+          return static_cast<bool>(out);
+        }
+
+        bool finish() override
+        {
+          out.close();
+          return !out.fail();
+        }
+
+      private:
+        std::ofstream out;
+        std::vector<unsigned char> row;
+      };
+
+      // PNG with a zlib stream made of stored deflate blocks. Each strip is one
+      // IDAT chunk; CRC and Adler-32 are updated as the bytes go out.
+      class PngWriter : public StripWriter
+      {
+      public:
+        static std::unique_ptr<StripWriter> open(const std::string &filename, cv::Size size)
+        {
+          std::unique_ptr<PngWriter> writer(new PngWriter());
+          writer->out.open(filename, std::ios::binary);
+          if (!writer->out)
+            return nullptr;
+
+          static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+          writer->out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+          unsigned char ihdr[13] = {};
+          putBe32(ihdr, static_cast<uint32_t>(size.width));
+          putBe32(ihdr + 4, static_cast<uint32_t>(size.height));
+          ihdr[8] = 8; // bit depth
+          ihdr[9] = 2; // truecolor RGB
+          writer->writeChunk("IHDR", ihdr, sizeof(ihdr));
+
+          // zlib header: deflate, 32K window, no preset dictionary.
+          writer->pending = {0x78, 0x01};
+          writer->row.resize(1 + static_cast<size_t>(size.width) * 3);
+          return writer;
+        }
+
+        bool write(const cv::Mat &rows) override
+        {
+          for (int y = 0; y < rows.rows; y++)
+          {
+            const uchar *src = rows.ptr<uchar>(y);
+            row[0] = 0; // filter type None
+            for (int x = 0; x < rows.cols; x++)
+            {
+              row[1 + x * 3 + 0] = src[x * 3 + 2];
+              row[1 + x * 3 + 1] = src[x * 3 + 1];
+              row[1 + x * 3 + 2] = src[x * 3 + 0];
+            }
+            appendStored(row.data(), row.size());
+          }
+
+          writeChunk("IDAT", pending.data(), pending.size());
+          pending.clear();
+          return static_cast<bool>(out);
+        }
+
+        bool finish() override
+        {
+          // Empty final stored block, then the Adler-32 of the raw data.
+          pending.insert(pending.end(), {0x01, 0x00, 0x00, 0xff, 0xff});
+          unsigned char adler[4];
+          putBe32(adler, (adlerB << 16) | adlerA);
+          pending.insert(pending.end(), adler, adler + 4);
+          writeChunk("IDAT", pending.data(), pending.size());
+          writeChunk("IEND", nullptr, 0);
+
+          out.close();
+          return !out.fail();
+        }
+
+      private:
+        void appendStored(const unsigned char *data, size_t size)
+        {
+          constexpr size_t kMaxStored = 65535;
+          updateAdler(data, size);
+
+          while (size > 0)
+          {
+            const size_t len = std::min(size, kMaxStored);
+            unsigned char header[5] = {0x00};
+            putLe16(header + 1, static_cast<uint16_t>(len));
+            putLe16(header + 3, static_cast<uint16_t>(~len));
+            pending.insert(pending.end(), header, header + 5);
+            pending.insert(pending.end(), data, data + len);
+            data += len;
+            size -= len;
+          }
+        }
+
+        void updateAdler(const unsigned char *data, size_t size)
+        {
+          // 5552 is the largest run that cannot overflow 32-bit sums.
+          constexpr size_t kRun = 5552;
+          while (size > 0)
+          {
+            size_t n = std::min(size, kRun);
+            for (size_t i = 0; i < n; i++)
+            {
+              adlerA += data[i];
+              adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+            data += n;
+            size -= n;
+          }
+        }
+
+        void writeChunk(const char type[4], const unsigned char *data, size_t size)
+        {
+          unsigned char length[4];
+          putBe32(length, static_cast<uint32_t>(size));
+          out.write(reinterpret_cast<const char *>(length), 4);
+          out.write(type, 4);
+          if (size > 0)
+            out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+
+          uint32_t crc = crc32(0xffffffffu, reinterpret_cast<const unsigned char *>(type), 4);
+          crc = crc32(crc, data, size) ^ 0xffffffffu;
+          unsigned char crcBytes[4];
+          putBe32(crcBytes, crc);
+          out.write(reinterpret_cast<const char *>(crcBytes), 4);
+        }
+
+        static uint32_t crc32(uint32_t crc, const unsigned char *data, size_t size)
+        {
+          static const std::array<uint32_t, 256> table = []
+          {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t n = 0; n < 256; n++)
+            {
+              uint32_t c = n;
+              for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+              t[n] = c;
+            }
+            return t;
+          }();
+
+          for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+          return crc;
+        }
+
+        std::ofstream out;
+        std::vector<unsigned char> row;
+        std::vector<unsigned char> pending;
+        uint32_t adlerA = 1;
+        uint32_t adlerB = 0;
+      };
+
+      // Formats without a row-by-row encoder: assemble the frame, encode at the end.
+      class EncodedWriter : public StripWriter
+      {
+      public:
+        static std::unique_ptr<StripWriter> open(const std::string &filename, cv::Size size, int quality)
+        {
+          std::unique_ptr<EncodedWriter> writer(new EncodedWriter());
+          writer->filename = filename;
+          writer->quality = quality;
+          writer->incremental = false;
+          writer->image = std::make_unique<ImageData>(size.width, size.height, CV_8UC3);
+          return writer;
+        }
+
+        bool write(const cv::Mat &rows) override
+        {
+          if (nextRow + rows.rows > image->height())
+            return false;
+
+          cv::Mat target = image->getMat().rowRange(nextRow, nextRow + rows.rows);
+          rows.copyTo(target);
+          nextRow += rows.rows;
+          return true;
+        }
+
+        bool finish() override
+        {
+          return ImageProcessor::saveImageFast(filename, *image, quality);
+        }
+
+      private:
+        std::string filename;
+        int quality = 85;
+        std::unique_ptr<ImageData> image;
+        int nextRow = 0;
+      };
+    }
+
+    std::unique_ptr<StripReader> StripReader::open(const std::string &filename)
+    {
+      const std::string ext = extensionOf(filename);
+
+      if (ext == "bmp" || ext == "ppm" || ext == "pgm" || ext == "pnm")
+      {
+        auto file = MappedFile::open(filename);
+        if (!file)
+        {
+          std::cerr << "Error: Could not open image: " << filename << std::endl;
+          return nullptr;
+        }
+
+        auto reader = ext == "bmp" ? BmpReader::open(std::move(file)) : PnmReader::open(std::move(file));
+        if (reader)
+          return reader;
+        // Compressed or exotic variants: let the regular decoder handle them.
+      }
+
+      return DecodedReader::open(filename);
+    }
+
+    std::unique_ptr<StripWriter> StripWriter::open(const std::string &filename, cv::Size size, int quality)
+    {
+      const std::string ext = extensionOf(filename);
+
+      std::unique_ptr<StripWriter> writer;
+      if (ext == "png")
+        writer = PngWriter::open(filename, size);
+      else if (ext == "bmp")
+        writer = BmpWriter::open(filename, size);
+      else if (ext == "ppm" || ext == "pnm")
+        writer = PpmWriter::open(filename, size);
+      else
+        writer = EncodedWriter::open(filename, size, quality);
+
+      if (!writer)
+        std::cerr << "Error: Could not create image: " << filename << std::endl;
+
+      return writer;
+    }
+
+  }
+}
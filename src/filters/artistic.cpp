@@ -1,54 +1,339 @@
 #include "filters/artistic.h"
+#include "kernels/kernels.h"
+#include "utils/utility.h"
 #include <opencv2/imgproc.hpp>
-#include <chrono>
-#include <iostream>
-#include <random>
 #include <algorithm>
 #include <cmath>
+#include <list>
+#include <mutex>
 
 namespace imagetui
 {
   namespace filters
   {
+    namespace
+    {
+      // Each oil-painting histogram bin holds a pixel count and per-channel sums.
+      constexpr int kOilBin = 4;
+      constexpr int kOilTileCols = 128;
+
+      inline int oilLevel(const uchar *pixel, int channels, int levels)
+      {
+        int value = channels >= 3 ? (pixel[0] + pixel[1] + pixel[2]) / 3 : pixel[0];
+        return value * (levels - 1) / 255;
+      }
+
+      inline void oilAccumulate(int *hist, const uchar *pixel, int channels, int levels, int sign)
+      {
+        int *bin = hist + oilLevel(pixel, channels, levels) * kOilBin;
+        bin[0] += sign;
+        if (channels >= 3)
+        {
+          bin[1] += sign * pixel[0];
+          bin[2] += sign * pixel[1];
+          bin[3] += sign * pixel[2];
+        }
+        else
+        {
+          bin[1] += sign * pixel[0];
+        }
+      }
+
+      // Gaussian falloff, exp(-k * (nx^2 + ny^2)), is the product of a column
+      // term and a row term, so the mask is two small Q15 tables rather than
+      // a full frame. Columns are expanded per byte for the vector kernel.
+      struct VignetteMask
+      {
+        cv::Size size;
+        int channels;
+        float strength;
+        std::vector<int16_t> columns;
+        std::vector<int16_t> rows;
+
+        bool matches(cv::Size s, int c, float k) const { return size == s && channels == c && strength == k; }
+      };
+
+      std::vector<int16_t> vignetteFalloff(int length, double k)
+      {
+        std::vector<int16_t> weights(length);
+        const double half = length / 2.0;
+        for (int i = 0; i < length; i++)
+        {
+          const double n = (i + 0.5 - half) / half;
+          weights[i] = static_cast<int16_t>(std::lround(kernels::kQ15One * std::exp(-k * n * n)));
+        }
+        return weights;
+      }
+
+      std::shared_ptr<const VignetteMask> buildVignetteMask(cv::Size size, int channels, float strength)
+      {
+        // Corners end up at (1 - strength) of their brightness.
+        const double corner = std::max(1.0 - strength, 1.0 / 256);
+        const double k = -std::log(corner) / 2;
+
+        auto mask = std::make_shared<VignetteMask>();
+        mask->size = size;
+        mask->channels = channels;
+        mask->strength = strength;
+        mask->rows = vignetteFalloff(size.height, k);
+
+        const std::vector<int16_t> columns = vignetteFalloff(size.width, k);
+        mask->columns.resize(static_cast<size_t>(size.width) * channels);
+        for (int x = 0; x < size.width; x++)
+          std::fill_n(mask->columns.begin() + static_cast<size_t>(x) * channels, channels, columns[x]);
+        return mask;
+      }
+
+      // Masks are shared by every op and thread, so a batch of same-sized
+      // images builds one; each thread also remembers the last mask it used
+      // and skips the lock while the geometry stays the same.
+      std::shared_ptr<const VignetteMask> vignetteMask(cv::Size size, int channels, float strength)
+      {
+        constexpr size_t kMaxMasks = 8;
+        static std::mutex mutex;
+        static std::list<std::shared_ptr<const VignetteMask>> recent;
+        thread_local std::shared_ptr<const VignetteMask> last;
+
+        if (last && last->matches(size, channels, strength))
+          return last;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(recent.begin(), recent.end(),
+                               [&](const auto &mask) { return mask->matches(size, channels, strength); });
+        if (it != recent.end())
+        {
+          recent.splice(recent.begin(), recent, it);
+        }
+        else
+        {
+          recent.push_front(buildVignetteMask(size, channels, strength));
+          if (recent.size() > kMaxMasks)
+            recent.pop_back();
+        }
+
+        last = recent.front();
+        return last;
+      }
+    }
+
     std::unique_ptr<core::ImageData> ArtisticFilters::sepia(const core::ImageData &input)
     {
       if (!input.isValid())
         return nullptr;
 
-      auto t0 = std::chrono::high_resolution_clock::now();
+      IMAGETUI_TRACE_SCOPE("filter.sepia");
+
+      auto result = core::Pipeline().then(sepiaOp()).run(input);
+
+      return result;
+    }
+
+    core::PointOp ArtisticFilters::sepiaOp()
+    {
+      static const kernels::ColorMatrix matrix = kernels::ColorMatrix::sepia();
+
+      return [](uchar *row, int width, int channels, const core::RowContext &)
+      {
+        if (channels == 3)
+        {
+          kernels::active().colorMatrix(row, row, width, matrix);
+        }
+        else if (channels > 3)
+        {
+          for (int x = 0; x < width; x++)
+            kernels::colorMatrixPixel(row + x * channels, row + x * channels, matrix);
+        }
+      };
+    }
+
+    std::unique_ptr<core::ImageData> ArtisticFilters::vignette(const core::ImageData &input, float strength)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.vignette");
+
+      return core::Pipeline().then(vignetteOp(strength)).run(input);
+    }
+
+    core::PointOp ArtisticFilters::vignetteOp(float strength)
+    {
+      strength = std::clamp(strength, 0.0f, 1.0f);
+
+      return [strength](uchar *row, int width, int channels, const core::RowContext &ctx)
+      {
+        auto mask = vignetteMask(ctx.imageSize, channels, strength);
+        const int scale = mask->rows[ctx.y];
+
+        if (channels != 4)
+        {
+          kernels::active().scaleQ15(row, row, static_cast<size_t>(width) * channels, mask->columns.data(), scale);
+        }
+        else
+        {
+          // Leave alpha alone.
+          for (int x = 0; x < width; x++)
+          {
+            const int weight = kernels::mulQ15(mask->columns[x * 4], scale);
+            for (int c = 0; c < 3; c++)
+              row[x * 4 + c] = static_cast<uchar>(kernels::mulQ15(row[x * 4 + c], weight));
+          }
+        }
+      };
+    }
+
+    std::unique_ptr<core::ImageData> ArtisticFilters::noise(const core::ImageData &input, int strength, uint32_t seed)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.noise");
+
+      return core::Pipeline().then(noiseOp(strength, seed)).run(input);
+    }
+
+    core::PointOp ArtisticFilters::noiseOp(int strength, uint32_t seed)
+    {
+      strength = std::clamp(strength, 0, kernels::kMaxNoiseStrength);
+
+      return [strength, seed](uchar *row, int width, int channels, const core::RowContext &ctx)
+      {
+        // Samples are keyed by byte position in the full image, so strips and
+        // tiles see the same noise as a whole-frame run.
+        uint64_t index = static_cast<uint64_t>(ctx.y) * ctx.imageSize.width * channels;
+        kernels::active().addNoise(row, row, static_cast<size_t>(width) * channels, index, seed, strength);
+      };
+    }
+
+    std::unique_ptr<core::ImageData> ArtisticFilters::oilPainting(const core::ImageData &input, int radius, int intensity)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.oil");
 
-      const cv::Mat &src = input.getMat();
-      cv::Mat result;
-      src.copyTo(result);
+      radius = std::clamp(radius, 1, kMaxOilRadius);
+      auto result = core::Pipeline().thenNeighborhood(oilPaintingOp(radius, intensity), radius).run(input);
 
-      cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &range)
-                        {
-        for (int y = range.start; y < range.end; y++) {
-          const cv::Vec3b * src_row = src.ptr<cv::Vec3b>(y);
-          cv::Vec3b * dst_row = result.ptr<cv::Vec3b>(y);
+      return result;
+    }
+
+    core::NeighborhoodOp ArtisticFilters::oilPaintingOp(int radius, int intensity)
+    {
+      radius = std::clamp(radius, 1, kMaxOilRadius);
+      const int levels = std::clamp(intensity, 1, kMaxOilLevels - 1) + 1;
+
+      return [radius, levels](const cv::Mat &src, cv::Mat &dst, const cv::Range &rows)
+      {
+        // One arena per band of rows, reused by every column tile in it: an
+        // always-empty histogram followed by one histogram per column.
+        // Tiles grow with the radius so that rebuilding the window histogram at
+        // the start of each tile row stays a small fraction of the work.
+        const int tileCols = std::max(kOilTileCols, 8 * radius);
+        const size_t histSize = static_cast<size_t>(levels) * kOilBin;
+        cv::AutoBuffer<int> arena((tileCols + 2 * radius + 1) * histSize);
+
+        for (int x = 0; x < src.cols; x += tileCols)
+        {
+          cv::Rect tile(x, rows.start, std::min(tileCols, src.cols - x), rows.size());
+          oilPaintingTile(src, dst, tile, radius, levels, arena.data());
+        }
+      };
+    }
+
+    // Sliding-histogram oil painting. Each column keeps a histogram of the
+    // 2r+1 pixels above and below the current row, so moving down one row
+    // costs one removal and one insertion per column. The window histogram is
+    // the sum of 2r+1 column histograms, so moving right subtracts one column
+    // and adds another. Either way the cost per pixel is O(levels), whatever
+    // the radius.
+    void ArtisticFilters::oilPaintingTile(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile,
+                                          int radius, int levels, int *columnHistograms)
+    {
+      const int channels = src.channels();
+      const int histSize = levels * kOilBin;
+      const int cx0 = std::max(0, tile.x - radius);
+      const int cx1 = std::min(src.cols, tile.x + tile.width + radius);
+      const int y0 = tile.y;
+      const int y1 = tile.y + tile.height;
+
+      const int *empty = columnHistograms;
+      int *columns = columnHistograms + histSize;
+      std::fill(columnHistograms, columnHistograms + static_cast<size_t>(cx1 - cx0 + 1) * histSize, 0);
 
-          for (int x = 0; x < src.cols; x++) {
-            const cv::Vec3b& pixel = src_row[x];
-            float blue = pixel[0];
-            float green = pixel[1];
-            float red = pixel[2];
+      auto column = [&](int c) -> const int *
+      {
+        return (c < cx0 || c >= cx1) ? empty : columns + static_cast<size_t>(c - cx0) * histSize;
+      };
 
-            float new_red = red * 0.393f + green * 0.769f + blue * 0.189f;
-            float new_green = red * 0.349f + green * 0.686f + blue * 0.168f;
-            float new_blue = red * 0.272f + green * 0.534f + blue * 0.131f;
+      auto accumulateRow = [&](int y, int sign)
+      {
+        if (y < 0 || y >= src.rows)
+          return;
+        const uchar *row = src.ptr<uchar>(y);
+        for (int c = cx0; c < cx1; c++)
+          oilAccumulate(columns + static_cast<size_t>(c - cx0) * histSize, row + c * channels, channels, levels, sign);
+      };
 
-            dst_row[x][0] = std::min(255.0f, new_blue);
-            dst_row[x][1] = std::min(255.0f, new_green);
-            dst_row[x][2] = std::min(255.0f, new_red);
+      for (int y = y0 - radius; y <= y0 + radius; y++)
+        accumulateRow(y, 1);
 
+      int window[kMaxOilLevels * kOilBin];
+
+      for (int y = y0; y < y1; y++)
+      {
+        if (y > y0)
+        {
+          accumulateRow(y - radius - 1, -1);
+          accumulateRow(y + radius, 1);
+        }
+
+        std::fill(window, window + histSize, 0);
+        for (int c = tile.x - radius; c <= tile.x + radius; c++)
+        {
+          const int *hist = column(c);
+          for (int i = 0; i < histSize; i++)
+            window[i] += hist[i];
+        }
+
+        const uchar *srcRow = src.ptr<uchar>(y);
+        uchar *dstRow = dst.ptr<uchar>(y);
+
+        for (int x = tile.x; x < tile.x + tile.width; x++)
+        {
+          if (x > tile.x)
+          {
+            const int *leaving = column(x - radius - 1);
+            const int *entering = column(x + radius);
+            for (int i = 0; i < histSize; i++)
+              window[i] += entering[i] - leaving[i];
           }
-        } });
 
-      auto t1 = std::chrono::high_resolution_clock::now();
-      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-      std::cout << "Sepia: " << ms << "ms" << std::endl;
+          int best = 0;
+          for (int level = 1; level < levels; level++)
+          {
+            if (window[level * kOilBin] > window[best * kOilBin])
+              best = level;
+          }
+
+          const int *bin = window + best * kOilBin;
+          const int count = std::max(1, bin[0]);
+          uchar *out = dstRow + x * channels;
 
-      return std::make_unique<core::ImageData>(std::move(result));
+          if (channels >= 3)
+          {
+            out[0] = static_cast<uchar>(bin[1] / count);
+            out[1] = static_cast<uchar>(bin[2] / count);
+            out[2] = static_cast<uchar>(bin[3] / count);
+            for (int c = 3; c < channels; c++)
+              out[c] = srcRow[x * channels + c];
+          }
+          else
+          {
+            out[0] = static_cast<uchar>(bin[1] / count);
+          }
+        }
+      }
     }
   }
-}
\ No newline at end of file
+}
@@ -1,7 +1,7 @@
 #include "filters/basic.h"
+#include "kernels/kernels.h"
+#include "utils/utility.h"
 #include <opencv2/imgproc.hpp>
-#include <chrono>
-#include <iostream>
 
 namespace imagetui
 {
@@ -13,32 +13,57 @@ namespace imagetui
       if (!input.isValid())
         return nullptr;
 
-      auto t0 = std::chrono::high_resolution_clock::now();
+      IMAGETUI_TRACE_SCOPE("filter.grayscale");
 
-      cv::Mat result;
+      std::unique_ptr<core::ImageData> output;
       const cv::Mat &src = input.getMat();
 
-      if (src.channels() == 3 || src.channels() == 4)
+      if (src.channels() == 3)
       {
-        cv::Mat gray;
-        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(gray, result, cv::COLOR_GRAY2BGR);
-      }
-      else if (src.channels() == 1)
-      {
-        cv::cvtColor(src, result, cv::COLOR_GRAY2BGR);
+        output = core::Pipeline().then(grayscaleOp()).run(input);
       }
       else
       {
-        result = src.clone();
+        cv::Mat result;
+        if (src.channels() == 4)
+        {
+          cv::Mat gray;
+          cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+          cv::cvtColor(gray, result, cv::COLOR_GRAY2BGR);
+        }
+        else if (src.channels() == 1)
+        {
+          cv::cvtColor(src, result, cv::COLOR_GRAY2BGR);
+        }
+        else
+        {
+          result = src.clone();
+        }
+        output = std::make_unique<core::ImageData>(std::move(result));
       }
 
-      auto t1 = std::chrono::high_resolution_clock::now();
-      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-      std::cout << "Grayscale: " << ms << "ms" << std::endl;
+      return output;
+    }
+
+    core::PointOp BasicFilters::grayscaleOp()
+    {
+      // BGR -> gray -> BGR in one pass; the matrix carries cvtColor's BGR2GRAY
+      // weights in every row, so results match the old two-pass conversion.
+      static const kernels::ColorMatrix matrix = kernels::ColorMatrix::gray();
 
-      return std::make_unique<core::ImageData>(std::move(result));
+      return [](uchar *row, int width, int channels, const core::RowContext &)
+      {
+        if (channels == 3)
+        {
+          kernels::active().colorMatrix(row, row, width, matrix);
+        }
+        else if (channels > 3)
+        {
+          for (int x = 0; x < width; x++)
+            kernels::colorMatrixPixel(row + x * channels, row + x * channels, matrix);
+        }
+      };
     }
 
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,73 @@
+#include "filters/color.h"
+#include "kernels/kernels.h"
+#include "utils/utility.h"
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace
+    {
+      constexpr kernels::Lut kInvertLut = kernels::makeLut([](int v) { return 255 - v; });
+    }
+
+    std::unique_ptr<core::ImageData> ColorFilters::invert(const core::ImageData &input)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.invert");
+
+      return core::Pipeline().then(invertOp()).run(input);
+    }
+
+    std::unique_ptr<core::ImageData> ColorFilters::brightness(const core::ImageData &input, int delta)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.brightness");
+
+      return core::Pipeline().then(brightnessOp(delta)).run(input);
+    }
+
+    core::PointOp ColorFilters::invertOp()
+    {
+      return lookupOp(kInvertLut);
+    }
+
+    core::PointOp ColorFilters::brightnessOp(int delta)
+    {
+      // A saturating add vectorizes directly, so no table is needed.
+      return [delta](uchar *row, int width, int channels, const core::RowContext &)
+      {
+        if (channels != 4)
+        {
+          kernels::active().addScalarSaturate(row, row, static_cast<size_t>(width) * channels, delta);
+        }
+        else
+        {
+          for (int x = 0; x < width; x++)
+            kernels::active().addScalarSaturate(row + x * 4, row + x * 4, 3, delta);
+        }
+      };
+    }
+
+    core::PointOp ColorFilters::lookupOp(const std::array<uint8_t, 256> &table)
+    {
+      return [table](uchar *row, int width, int channels, const core::RowContext &)
+      {
+        if (channels != 4)
+        {
+          kernels::applyLut(row, row, static_cast<size_t>(width) * channels, table);
+        }
+        else
+        {
+          for (int x = 0; x < width; x++)
+            kernels::applyLut(row + x * 4, row + x * 4, 3, table);
+        }
+      };
+    }
+
+  }
+}
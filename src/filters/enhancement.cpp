@@ -0,0 +1,47 @@
+#include "filters/enhancement.h"
+#include "filters/color.h"
+#include "kernels/kernels.h"
+#include "utils/utility.h"
+#include <algorithm>
+#include <cmath>
+
+namespace imagetui
+{
+  namespace filters
+  {
+
+    std::unique_ptr<core::ImageData> EnhancementFilters::contrast(const core::ImageData &input, float factor)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.contrast");
+
+      return core::Pipeline().then(contrastOp(factor)).run(input);
+    }
+
+    std::unique_ptr<core::ImageData> EnhancementFilters::gamma(const core::ImageData &input, float gamma)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.gamma");
+
+      return core::Pipeline().then(gammaOp(gamma)).run(input);
+    }
+
+    core::PointOp EnhancementFilters::contrastOp(float factor)
+    {
+      return ColorFilters::lookupOp(kernels::makeLut([factor](int v)
+                                                     { return static_cast<int>(std::lround((v - 127.5f) * factor + 127.5f)); }));
+    }
+
+    core::PointOp EnhancementFilters::gammaOp(float gamma)
+    {
+      const double exponent = 1.0 / std::max(gamma, 0.01f);
+      return ColorFilters::lookupOp(kernels::makeLut([exponent](int v)
+                                                     { return static_cast<int>(std::lround(255.0 * std::pow(v / 255.0, exponent))); }));
+    }
+
+  }
+}
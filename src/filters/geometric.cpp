@@ -0,0 +1,358 @@
+#include "filters/geometric.h"
+#include "kernels/kernels.h"
+#include "utils/utility.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace
+    {
+      template <int Bytes>
+      struct Pixel
+      {
+        uint8_t bytes[Bytes];
+      };
+
+      bool supportedPixel(const cv::Mat &mat)
+      {
+        if (mat.elemSize() >= 1 && mat.elemSize() <= 4)
+          return true;
+        std::cerr << "Error: Unsupported pixel size " << mat.elemSize() << std::endl;
+        return false;
+      }
+
+      // Calls f with a Pixel type matching the image's element size, which
+      // supportedPixel() has already checked.
+      template <typename F>
+      void withPixel(size_t elemSize, F &&f)
+      {
+        switch (elemSize)
+        {
+        case 1:
+          f(Pixel<1>{});
+          break;
+        case 2:
+          f(Pixel<2>{});
+          break;
+        case 3:
+          f(Pixel<3>{});
+          break;
+        default:
+          f(Pixel<4>{});
+          break;
+        }
+      }
+
+      // Resampling weights for one axis: output i reads `taps` source samples
+      // from start[i], weighted by weights[i * taps ...] in Q14.
+      struct ResizeTaps
+      {
+        int taps = 0;
+        std::vector<int> start;
+        std::vector<int16_t> weights;
+      };
+
+      ResizeTaps resizeTaps(int srcLength, int dstLength)
+      {
+        const double scale = static_cast<double>(srcLength) / dstLength;
+        // Stretching the triangle over `scale` source samples when shrinking
+        // turns it into an area filter, so nothing aliases.
+        const double support = std::max(1.0, scale);
+
+        ResizeTaps t;
+        t.taps = std::min(srcLength, static_cast<int>(std::ceil(support)) * 2 + 1);
+        t.start.resize(dstLength);
+        t.weights.assign(static_cast<size_t>(dstLength) * t.taps, 0);
+
+        std::vector<double> w(t.taps);
+        for (int i = 0; i < dstLength; i++)
+        {
+          const double center = (i + 0.5) * scale;
+          const int first = std::clamp(static_cast<int>(std::floor(center - support)), 0, srcLength - t.taps);
+          double sum = 0.0;
+          for (int k = 0; k < t.taps; k++)
+          {
+            w[k] = std::max(0.0, 1.0 - std::abs(first + k + 0.5 - center) / support);
+            sum += w[k];
+          }
+
+          // Quantize and put the rounding error on the largest tap, so every
+          // set sums to exactly one and flat areas stay flat.
+          int16_t *q = &t.weights[static_cast<size_t>(i) * t.taps];
+          int total = 0, largest = 0;
+          for (int k = 0; k < t.taps; k++)
+          {
+            q[k] = static_cast<int16_t>(std::lround(w[k] / sum * (1 << kernels::kFilterBits)));
+            total += q[k];
+            if (q[k] > q[largest])
+              largest = k;
+          }
+          q[largest] = static_cast<int16_t>(q[largest] + (1 << kernels::kFilterBits) - total);
+          t.start[i] = first;
+        }
+        return t;
+      }
+
+      template <int Channels>
+      void resizeRow(const uchar *src, uchar *dst, const ResizeTaps &t)
+      {
+        // Locals, so the byte stores can't make the compiler reload the table.
+        const int taps = t.taps;
+        const int width = static_cast<int>(t.start.size());
+        const int *start = t.start.data();
+        const int16_t *w = t.weights.data();
+
+        for (int x = 0; x < width; x++, w += taps)
+        {
+          const uchar *s = src + static_cast<size_t>(start[x]) * Channels;
+          int acc[Channels];
+          for (int c = 0; c < Channels; c++)
+            acc[c] = 1 << (kernels::kFilterBits - 1);
+          for (int k = 0; k < taps; k++, s += Channels)
+            for (int c = 0; c < Channels; c++)
+              acc[c] += w[k] * s[c];
+          for (int c = 0; c < Channels; c++)
+            dst[x * Channels + c] = static_cast<uchar>(std::clamp(acc[c] >> kernels::kFilterBits, 0, 255));
+        }
+      }
+
+      void resizeRow(const uchar *src, uchar *dst, int channels, const ResizeTaps &t)
+      {
+        switch (channels)
+        {
+        case 1:
+          resizeRow<1>(src, dst, t);
+          break;
+        case 2:
+          resizeRow<2>(src, dst, t);
+          break;
+        case 3:
+          resizeRow<3>(src, dst, t);
+          break;
+        default:
+          resizeRow<4>(src, dst, t);
+          break;
+        }
+      }
+    }
+
+    std::unique_ptr<core::ImageData> GeometricFilters::crop(const core::ImageData &input, const cv::Rect &rect)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      const cv::Rect clipped = rect & cv::Rect(0, 0, input.width(), input.height());
+      if (clipped.empty())
+      {
+        std::cerr << "Error: Crop rectangle is outside the image" << std::endl;
+        return nullptr;
+      }
+
+      return std::make_unique<core::ImageData>(input.getMat()(clipped));
+    }
+
+    std::unique_ptr<core::ImageData> GeometricFilters::flip(const core::ImageData &input, FlipMode mode)
+    {
+      if (!input.isValid() || !supportedPixel(input.getMat()))
+        return nullptr;
+
+      IMAGETUI_TRACE_SCOPE("filter.flip");
+
+      // cv::Mat steps are unsigned, so a flip can't be a view; it is a single
+      // copy pass instead.
+      if (mode == FlipMode::Horizontal)
+        return core::Pipeline().thenNeighborhood(mirrorOp(), 0).run(input);
+
+      const cv::Mat &src = input.getMat();
+      auto output = std::make_unique<core::ImageData>(src.cols, src.rows, src.type());
+      reverseRows(src, output->getMat(), mode == FlipMode::Both);
+      return output;
+    }
+
+    std::unique_ptr<core::ImageData> GeometricFilters::rotate(const core::ImageData &input, int degrees)
+    {
+      if (!input.isValid() || !supportedPixel(input.getMat()))
+        return nullptr;
+
+      degrees = ((degrees % 360) + 360) % 360;
+      if (degrees % 90 != 0)
+      {
+        std::cerr << "Error: Rotation must be a multiple of 90 degrees" << std::endl;
+        return nullptr;
+      }
+
+      IMAGETUI_TRACE_SCOPE("filter.rotate");
+
+      const cv::Mat &src = input.getMat();
+      const bool quarter = degrees == 90 || degrees == 270;
+      auto output = std::make_unique<core::ImageData>(quarter ? src.rows : src.cols, quarter ? src.cols : src.rows,
+                                                      src.type());
+      cv::Mat &dst = output->getMat();
+
+      if (degrees == 0)
+        src.copyTo(dst);
+      else if (degrees == 180)
+        reverseRows(src, dst, true);
+      else
+        rotateQuarter(src, dst, degrees == 90);
+
+      return output;
+    }
+
+    std::unique_ptr<core::ImageData> GeometricFilters::resize(const core::ImageData &input, cv::Size size)
+    {
+      if (!input.isValid())
+        return nullptr;
+
+      if (size.width <= 0 || size.height <= 0)
+      {
+        std::cerr << "Error: Invalid resize target " << size.width << "x" << size.height << std::endl;
+        return nullptr;
+      }
+
+      const cv::Mat &src = input.getMat();
+      if (src.depth() != CV_8U || src.channels() > 4)
+      {
+        std::cerr << "Error: Resize needs an 8-bit image with at most 4 channels" << std::endl;
+        return nullptr;
+      }
+
+      IMAGETUI_TRACE_SCOPE("filter.resize");
+
+      const int channels = src.channels();
+      const ResizeTaps columns = resizeTaps(src.cols, size.width);
+      const ResizeTaps rows = resizeTaps(src.rows, size.height);
+
+      auto horizontal = [&](const cv::Mat &from, cv::Mat &to)
+      {
+        cv::parallel_for_(cv::Range(0, from.rows), [&](const cv::Range &range)
+                          {
+          for (int y = range.start; y < range.end; y++)
+            resizeRow(from.ptr<uchar>(y), to.ptr<uchar>(y), channels, columns); });
+      };
+
+      // Blends whole rows with the vector kernel.
+      auto vertical = [&](const cv::Mat &from, cv::Mat &to)
+      {
+        const size_t rowBytes = static_cast<size_t>(from.cols) * channels;
+        cv::parallel_for_(cv::Range(0, to.rows), [&](const cv::Range &range)
+                          {
+          std::vector<const uint8_t *> taps(rows.taps);
+          for (int y = range.start; y < range.end; y++) {
+            for (int k = 0; k < rows.taps; k++)
+              taps[k] = from.ptr<uchar>(rows.start[y] + k);
+            kernels::active().weightedRows(taps.data(), &rows.weights[static_cast<size_t>(y) * rows.taps], rows.taps,
+                                           to.ptr<uchar>(y), rowBytes);
+          } });
+      };
+
+      auto output = std::make_unique<core::ImageData>(size.width, size.height, src.type());
+      cv::Mat &dst = output->getMat();
+      cv::Mat between;
+
+      // The horizontal pass is the scalar one, so run it on whichever of the
+      // source or output row counts is smaller.
+      if (size.height < src.rows)
+      {
+        core::BufferPool::create(between, size.height, src.cols, src.type());
+        vertical(src, between);
+        horizontal(between, dst);
+      }
+      else
+      {
+        core::BufferPool::create(between, src.rows, size.width, src.type());
+        horizontal(src, between);
+        vertical(between, dst);
+      }
+
+      return output;
+    }
+
+    std::unique_ptr<core::ImageData> GeometricFilters::loadFitted(const std::string &filename, cv::Size bounds)
+    {
+      auto image = core::ImageProcessor::loadImageReduced(filename, bounds);
+      if (!image)
+        return nullptr;
+
+      const cv::Size target = core::ImageProcessor::fitWithin(image->getMat().size(), bounds);
+      if (target == image->getMat().size())
+        return image;
+      return resize(*image, target);
+    }
+
+    core::NeighborhoodOp GeometricFilters::mirrorOp()
+    {
+      return [](const cv::Mat &src, cv::Mat &dst, const cv::Range &rows)
+      {
+        withPixel(src.elemSize(), [&](auto pixel)
+                  {
+          using P = decltype(pixel);
+          for (int y = rows.start; y < rows.end; y++) {
+            const P *in = src.ptr<P>(y);
+            std::reverse_copy(in, in + src.cols, dst.ptr<P>(y));
+          } });
+      };
+    }
+
+    // Walks the destination in square blocks so that the column of source
+    // pixels each block reads stays in L1 until every row using it is done.
+    void GeometricFilters::rotateQuarter(const cv::Mat &src, cv::Mat &dst, bool clockwise)
+    {
+      const int bandCount = (dst.rows + kRotateBlock - 1) / kRotateBlock;
+
+      withPixel(src.elemSize(), [&](auto pixel)
+                {
+        using P = decltype(pixel);
+        cv::parallel_for_(cv::Range(0, bandCount), [&](const cv::Range &bands) {
+          for (int band = bands.start; band < bands.end; band++) {
+            const int r0 = band * kRotateBlock;
+            const int r1 = std::min(dst.rows, r0 + kRotateBlock);
+            for (int c0 = 0; c0 < dst.cols; c0 += kRotateBlock) {
+              const int c1 = std::min(dst.cols, c0 + kRotateBlock);
+              for (int r = r0; r < r1; r++) {
+                P *out = dst.ptr<P>(r);
+                if (clockwise) {
+                  // dst(r, c) = src(rows - 1 - c, r)
+                  for (int c = c0; c < c1; c++)
+                    out[c] = src.ptr<P>(src.rows - 1 - c)[r];
+                } else {
+                  // dst(r, c) = src(c, cols - 1 - r)
+                  const int x = src.cols - 1 - r;
+                  for (int c = c0; c < c1; c++)
+                    out[c] = src.ptr<P>(c)[x];
+                }
+              }
+            }
+          }
+        }); });
+    }
+
+    void GeometricFilters::reverseRows(const cv::Mat &src, cv::Mat &dst, bool reversePixels)
+    {
+      const size_t rowBytes = static_cast<size_t>(src.cols) * src.elemSize();
+
+      cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &range)
+                        {
+        for (int y = range.start; y < range.end; y++) {
+          const uchar *in = src.ptr<uchar>(src.rows - 1 - y);
+          uchar *out = dst.ptr<uchar>(y);
+          if (!reversePixels) {
+            std::memcpy(out, in, rowBytes);
+            continue;
+          }
+          withPixel(src.elemSize(), [&](auto pixel) {
+            using P = decltype(pixel);
+            const P *first = reinterpret_cast<const P *>(in);
+            std::reverse_copy(first, first + src.cols, reinterpret_cast<P *>(out));
+          });
+        } });
+    }
+
+  }
+}
@@ -0,0 +1,232 @@
+#include "kernels.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(IMAGETUI_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+
+      namespace
+      {
+        enum class Isa
+        {
+          Scalar,
+          Sse41,
+          Avx2,
+          Avx512
+        };
+
+        Isa detectIsa()
+        {
+#if defined(IMAGETUI_X86_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+          __builtin_cpu_init();
+          if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+            return Isa::Avx512;
+          if (__builtin_cpu_supports("avx2"))
+            return Isa::Avx2;
+          if (__builtin_cpu_supports("sse4.1"))
+            return Isa::Sse41;
+#elif defined(IMAGETUI_X86_KERNELS) && defined(_MSC_VER)
+          int info[4];
+          __cpuid(info, 1);
+          const bool sse41 = (info[2] & (1 << 19)) != 0;
+          const bool osxsave = (info[2] & (1 << 27)) != 0;
+          const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+          const bool avxState = (xcr0 & 0x6) == 0x6;
+          const bool avx512State = (xcr0 & 0xe6) == 0xe6;
+
+          __cpuidex(info, 7, 0);
+          const bool avx2 = (info[1] & (1 << 5)) != 0;
+          const bool avx512f = (info[1] & (1 << 16)) != 0;
+          const bool avx512bw = (info[1] & (1 << 30)) != 0;
+
+          if (avx512f && avx512bw && avx512State)
+            return Isa::Avx512;
+          if (avx2 && avxState)
+            return Isa::Avx2;
+          if (sse41)
+            return Isa::Sse41;
+#endif
+          return Isa::Scalar;
+        }
+
+        Isa requestedIsa(Isa detected)
+        {
+          const char *env = std::getenv("IMAGETUI_KERNELS");
+          if (!env)
+            return detected;
+
+          Isa wanted = detected;
+          if (std::strcmp(env, "scalar") == 0)
+            wanted = Isa::Scalar;
+          else if (std::strcmp(env, "sse41") == 0)
+            wanted = Isa::Sse41;
+          else if (std::strcmp(env, "avx2") == 0)
+            wanted = Isa::Avx2;
+          else if (std::strcmp(env, "avx512") == 0)
+            wanted = Isa::Avx512;
+
+          // Never pick something wider than the CPU actually supports.
+          return wanted < detected ? wanted : detected;
+        }
+
+        const KernelTable *tableFor(Isa isa)
+        {
+#ifdef IMAGETUI_X86_KERNELS
+          switch (isa)
+          {
+          case Isa::Avx512:
+            return detail::avx512Table();
+          case Isa::Avx2:
+            return detail::avx2Table();
+          case Isa::Sse41:
+            return detail::sse41Table();
+          case Isa::Scalar:
+            break;
+          }
+#else
+          (void)isa;
+#endif
+          return &scalar();
+        }
+
+        const KernelTable *selectTable()
+        {
+          const KernelTable *table = tableFor(requestedIsa(detectIsa()));
+
+#ifdef DEBUG_BUILD
+          if (table != &scalar() && !verify(*table))
+          {
+            std::cerr << "Warning: " << table->name << " kernels disagree with scalar reference, using scalar" << std::endl;
+            table = &scalar();
+          }
+#endif
+
+          return table;
+        }
+      }
+
+      const KernelTable &active()
+      {
+        static const KernelTable *table = selectTable();
+        return *table;
+      }
+
+      std::vector<const KernelTable *> available()
+      {
+        std::vector<const KernelTable *> tables;
+        const Isa widest = requestedIsa(detectIsa());
+        for (Isa isa : {Isa::Scalar, Isa::Sse41, Isa::Avx2, Isa::Avx512})
+        {
+          const KernelTable *table = tableFor(isa);
+          if (isa <= widest && std::find(tables.begin(), tables.end(), table) == tables.end())
+            tables.push_back(table);
+        }
+        return tables;
+      }
+
+      const KernelTable &scalar()
+      {
+        static const KernelTable table{"scalar", detail::colorMatrixScalar, detail::addSaturateScalar,
+                                       detail::addScalarSaturateScalar, detail::addNoiseScalar,
+                                       detail::scaleQ15Scalar, detail::weightedRowsScalar};
+        return table;
+      }
+
+      bool verify(const KernelTable &table)
+      {
+        // Odd length so every kernel exercises both its vector body and its tail.
+        constexpr size_t kPixels = 1031;
+        constexpr size_t kBytes = kPixels * 3;
+
+        std::vector<uint8_t> a(kBytes), b(kBytes), expected(kBytes), actual(kBytes);
+        uint32_t state = 0x12345678u;
+        for (size_t i = 0; i < kBytes; i++)
+        {
+          state = state * 1664525u + 1013904223u;
+          a[i] = static_cast<uint8_t>(state >> 24);
+          b[i] = static_cast<uint8_t>(state >> 16);
+        }
+
+        const float contrast[3][3] = {{1.6f, -0.3f, -0.3f}, {-0.3f, 1.6f, -0.3f}, {-0.3f, -0.3f, 1.6f}};
+        const float offset[3] = {-12.0f, 4.0f, 30.0f};
+        const ColorMatrix matrices[] = {ColorMatrix::sepia(), ColorMatrix::gray(),
+                                        ColorMatrix::fromFloat(contrast, offset)};
+
+        const KernelTable &ref = scalar();
+        for (const auto &m : matrices)
+        {
+          ref.colorMatrix(a.data(), expected.data(), kPixels, m);
+          table.colorMatrix(a.data(), actual.data(), kPixels, m);
+          if (expected != actual)
+            return false;
+        }
+
+        ref.addSaturate(a.data(), b.data(), expected.data(), kBytes);
+        table.addSaturate(a.data(), b.data(), actual.data(), kBytes);
+        if (expected != actual)
+          return false;
+
+        for (int delta : {-300, -37, 0, 58, 255})
+        {
+          ref.addScalarSaturate(a.data(), expected.data(), kBytes, delta);
+          table.addScalarSaturate(a.data(), actual.data(), kBytes, delta);
+          if (expected != actual)
+            return false;
+        }
+
+        // Odd and even starts, and a run across a change of the counter's high word.
+        const uint64_t starts[] = {0, 7, 12345678901ull, (uint64_t(1) << 33) - 101};
+        for (uint64_t index : starts)
+        {
+          for (int strength : {0, 25, kMaxNoiseStrength})
+          {
+            ref.addNoise(a.data(), expected.data(), kBytes, index, 42u, strength);
+            table.addNoise(a.data(), actual.data(), kBytes, index, 42u, strength);
+            if (expected != actual)
+              return false;
+          }
+        }
+
+        std::vector<int16_t> weights(kBytes);
+        for (size_t i = 0; i < kBytes; i++)
+          weights[i] = static_cast<int16_t>((a[i] << 7 | b[i] >> 1) % (kQ15One + 1));
+        weights[0] = kQ15One;
+        weights[1] = 0;
+        for (int scale : {0, 1, 12345, kQ15One})
+        {
+          ref.scaleQ15(a.data(), expected.data(), kBytes, weights.data(), scale);
+          table.scaleQ15(a.data(), actual.data(), kBytes, weights.data(), scale);
+          if (expected != actual)
+            return false;
+        }
+
+        // Tap counts covering pairs, a lone odd tap, and negative lobes.
+        const int16_t taps[] = {16384, -2048, 9000, 12000, -4567, 1500, -8000, 12000, 31000};
+        for (int count : {1, 2, 5, 9})
+        {
+          const uint8_t *rows[9];
+          for (int k = 0; k < count; k++)
+            rows[k] = (k % 2 ? b.data() : a.data()) + k;
+          ref.weightedRows(rows, taps, count, expected.data(), kBytes - 16);
+          table.weightedRows(rows, taps, count, actual.data(), kBytes - 16);
+          if (expected != actual)
+            return false;
+        }
+
+        return true;
+      }
+
+    }
+  }
+}
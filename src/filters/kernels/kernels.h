@@ -0,0 +1,183 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Point-operation kernels shared by the filters. Every kernel has a scalar
+// reference and optional SSE4.1/AVX2/AVX-512 builds; the widest one the CPU
+// supports is picked once, on first use. All versions use the same integer
+// math so they agree bit for bit.
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+
+      // 3x3 transform over interleaved BGR pixels in fixed point:
+      //   out[k] = clamp((sum_j coeffs[k][j] * in[j] + bias[k]) >> shift, 0, 255)
+      // Rows and columns are both in B, G, R order.
+      struct ColorMatrix
+      {
+        int16_t coeffs[3][3];
+        int32_t bias[3];
+        int shift;
+
+        static ColorMatrix fromFloat(const float matrix[3][3], const float offset[3] = nullptr, int shift = 12);
+        static ColorMatrix sepia();
+        static ColorMatrix gray();
+
+        bool uniformRows() const;
+      };
+
+      // Byte -> byte table for per-channel tone curves.
+      using Lut = std::array<uint8_t, 256>;
+
+      // Tabulates f over 0..255, clamped; constexpr so fixed curves cost
+      // nothing at runtime.
+      template <typename F>
+      constexpr Lut makeLut(F f)
+      {
+        Lut lut{};
+        for (int v = 0; v < 256; v++)
+        {
+          const int mapped = f(v);
+          lut[v] = static_cast<uint8_t>(mapped < 0 ? 0 : (mapped > 255 ? 255 : mapped));
+        }
+        return lut;
+      }
+
+      // Weights in Q15 fixed point; kQ15One leaves a byte unchanged.
+      constexpr int kQ15One = 32767;
+
+      // Rounded Q15 product, as computed by pmulhrsw.
+      static inline int mulQ15(int a, int b)
+      {
+        return (a * b + 0x4000) >> 15;
+      }
+
+      // Resampling weights are Q14, so a tap set sums to 1 << kFilterBits.
+      constexpr int kFilterBits = 14;
+
+      // Noise strength is capped so (sample * strength) fits a 16-bit lane.
+      constexpr int kMaxNoiseStrength = 127;
+
+      struct KernelTable
+      {
+        const char *name;
+        void (*colorMatrix)(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m);
+        void (*addSaturate)(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n);
+        void (*addScalarSaturate)(const uint8_t *src, uint8_t *dst, size_t n, int delta);
+        // dst[i] = clamp(src[i] + noiseSample(index + i, seed, strength), 0, 255)
+        void (*addNoise)(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength);
+        // dst[i] = mulQ15(src[i], mulQ15(weights[i], scale)), weights and scale in [0, kQ15One]
+        void (*scaleQ15)(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale);
+        // dst[i] = clamp((sum_k weights[k] * rows[k][i] + half) >> kFilterBits, 0, 255)
+        void (*weightedRows)(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n);
+      };
+
+      // Kernel set chosen for this CPU. IMAGETUI_KERNELS=scalar|sse41|avx2|avx512
+      // forces a narrower set, which is handy when comparing results.
+      const KernelTable &active();
+      const KernelTable &scalar();
+      // Every set this CPU supports, capped by IMAGETUI_KERNELS; scalar first.
+      std::vector<const KernelTable *> available();
+
+      // dst[i] = lut[src[i]]. Not in the table: a 256-entry byte gather has no
+      // vector form that beats scalar loads below AVX-512 VBMI.
+      void applyLut(const uint8_t *src, uint8_t *dst, size_t n, const Lut &lut);
+
+      // Runs `table` against the scalar reference on synthetic data.
+      bool verify(const KernelTable &table);
+
+      // Applies `m` to a single pixel; used for 4-channel rows the vector paths skip.
+      static inline void colorMatrixPixel(const uint8_t *in, uint8_t *out, const ColorMatrix &m)
+      {
+        int b = in[0], g = in[1], r = in[2];
+        int v[3];
+        for (int k = 0; k < 3; k++)
+        {
+          v[k] = (m.coeffs[k][0] * b + m.coeffs[k][1] * g + m.coeffs[k][2] * r + m.bias[k]) >> m.shift;
+          v[k] = v[k] < 0 ? 0 : (v[k] > 255 ? 255 : v[k]);
+        }
+        out[0] = static_cast<uint8_t>(v[0]);
+        out[1] = static_cast<uint8_t>(v[1]);
+        out[2] = static_cast<uint8_t>(v[2]);
+      }
+
+      // Chris Wellons' lowbias32 integer hash.
+      static inline uint32_t lowbias32(uint32_t x)
+      {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+      }
+
+      static inline uint32_t noiseKey(uint32_t seed, uint32_t counterHigh)
+      {
+        return lowbias32(seed ^ lowbias32(counterHigh + 0x9e3779b9u));
+      }
+
+      // Counter-based noise: a byte's sample depends only on the seed and its
+      // index in the whole image, never on how the work was split up. One hash
+      // covers two bytes; each 16-bit half u gives a triangular sample
+      // ((u & 255) + (u >> 8) - 255) * strength / 256 rounded, within +-strength.
+      static inline int noiseSample(uint64_t index, uint32_t seed, int strength)
+      {
+        const uint64_t counter = index >> 1;
+        const uint32_t h = lowbias32(static_cast<uint32_t>(counter) ^ noiseKey(seed, static_cast<uint32_t>(counter >> 32)));
+        const uint32_t half = (index & 1) ? h >> 16 : h & 0xffffu;
+        return ((static_cast<int>(half & 255) + static_cast<int>(half >> 8) - 255) * strength + 128) >> 8;
+      }
+
+      namespace detail
+      {
+        void colorMatrixScalar(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m);
+        void addSaturateScalar(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n);
+        void addScalarSaturateScalar(const uint8_t *src, uint8_t *dst, size_t n, int delta);
+        void addNoiseScalar(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength);
+        void scaleQ15Scalar(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale);
+        void weightedRowsScalar(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n);
+
+        // weightedRows over bytes [begin, end); the vector kernels' tail.
+        static inline void weightedRowsRange(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst,
+                                             size_t begin, size_t end)
+        {
+          for (size_t i = begin; i < end; i++)
+          {
+            int acc = 1 << (kFilterBits - 1);
+            for (int k = 0; k < taps; k++)
+              acc += weights[k] * rows[k][i];
+            dst[i] = static_cast<uint8_t>(acc < 0 ? 0 : ((acc >> kFilterBits) > 255 ? 255 : acc >> kFilterBits));
+          }
+        }
+
+        // Packs the weights of taps k and k + 1 for pmaddwd; an odd last tap
+        // pairs with a zero weight.
+        static inline uint32_t weightPair(const int16_t *weights, int taps, int k)
+        {
+          const uint16_t second = k + 1 < taps ? static_cast<uint16_t>(weights[k + 1]) : 0;
+          return (static_cast<uint32_t>(second) << 16) | static_cast<uint16_t>(weights[k]);
+        }
+
+        // Bytes from `index` up to where the counter's high word changes; the
+        // vector kernels hold the key fixed for that long.
+        static inline uint64_t noiseRun(uint64_t index, size_t n)
+        {
+          uint64_t untilWrap = ((uint64_t(1) << 32) - static_cast<uint32_t>(index >> 1)) * 2 - (index & 1);
+          return n < untilWrap ? n : untilWrap;
+        }
+
+        const KernelTable *sse41Table();
+        const KernelTable *avx2Table();
+        const KernelTable *avx512Table();
+      }
+
+    }
+  }
+}
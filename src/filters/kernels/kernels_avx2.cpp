@@ -0,0 +1,254 @@
+#include "kernels.h"
+#include "shuffle_tables.h"
+#include <immintrin.h>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+      namespace detail
+      {
+        namespace
+        {
+          // Each 128-bit lane holds its own group of 16 pixels, so the lane-local
+          // pshufb/unpack/pack sequence is identical to the SSE4.1 kernel.
+          inline __m256i mask(const int8_t (&bytes)[16])
+          {
+            return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(bytes)));
+          }
+
+          inline __m256i loadLanes(const uint8_t *lo, const uint8_t *hi)
+          {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lo));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hi));
+            return _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+          }
+
+          inline void storeLanes(uint8_t *lo, uint8_t *hi, __m256i v)
+          {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(lo), _mm256_castsi256_si128(v));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(hi), _mm256_extracti128_si256(v, 1));
+          }
+
+          inline __m256i gather3(__m256i c0, __m256i c1, __m256i c2, const int8_t (&m)[3][16])
+          {
+            return _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(c0, mask(m[0])),
+                                                   _mm256_shuffle_epi8(c1, mask(m[1]))),
+                                   _mm256_shuffle_epi8(c2, mask(m[2])));
+          }
+
+          inline __m256i matrixRow(const __m256i (&bg)[4], const __m256i (&r)[4],
+                                   __m256i cbg, __m256i cr, __m256i bias, __m128i shift)
+          {
+            __m256i acc[4];
+            for (int i = 0; i < 4; i++)
+            {
+              __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(bg[i], cbg), _mm256_madd_epi16(r[i], cr));
+              acc[i] = _mm256_sra_epi32(_mm256_add_epi32(sum, bias), shift);
+            }
+            return _mm256_packus_epi16(_mm256_packs_epi32(acc[0], acc[1]), _mm256_packs_epi32(acc[2], acc[3]));
+          }
+
+          void colorMatrixAvx2(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m)
+          {
+            const auto &masks = kBgrShuffleMasks;
+            const __m256i zero = _mm256_setzero_si256();
+            const __m128i shift = _mm_cvtsi32_si128(m.shift);
+            const bool uniform = m.uniformRows();
+
+            __m256i cbg[3], cr[3], bias[3];
+            for (int k = 0; k < 3; k++)
+            {
+              uint32_t pair = (static_cast<uint32_t>(static_cast<uint16_t>(m.coeffs[k][1])) << 16) |
+                              static_cast<uint16_t>(m.coeffs[k][0]);
+              cbg[k] = _mm256_set1_epi32(static_cast<int32_t>(pair));
+              cr[k] = _mm256_set1_epi32(static_cast<uint16_t>(m.coeffs[k][2]));
+              bias[k] = _mm256_set1_epi32(m.bias[k]);
+            }
+
+            size_t i = 0;
+            for (; i + 32 <= pixels; i += 32)
+            {
+              const uint8_t *s = src + i * 3;
+              __m256i c0 = loadLanes(s, s + 48);
+              __m256i c1 = loadLanes(s + 16, s + 64);
+              __m256i c2 = loadLanes(s + 32, s + 80);
+
+              __m256i b = gather3(c0, c1, c2, masks.deinterleave[0]);
+              __m256i g = gather3(c0, c1, c2, masks.deinterleave[1]);
+              __m256i r = gather3(c0, c1, c2, masks.deinterleave[2]);
+
+              __m256i bl = _mm256_unpacklo_epi8(b, zero), bh = _mm256_unpackhi_epi8(b, zero);
+              __m256i gl = _mm256_unpacklo_epi8(g, zero), gh = _mm256_unpackhi_epi8(g, zero);
+              __m256i rl = _mm256_unpacklo_epi8(r, zero), rh = _mm256_unpackhi_epi8(r, zero);
+
+              const __m256i bgPairs[4] = {_mm256_unpacklo_epi16(bl, gl), _mm256_unpackhi_epi16(bl, gl),
+                                          _mm256_unpacklo_epi16(bh, gh), _mm256_unpackhi_epi16(bh, gh)};
+              const __m256i rPairs[4] = {_mm256_unpacklo_epi16(rl, zero), _mm256_unpackhi_epi16(rl, zero),
+                                         _mm256_unpacklo_epi16(rh, zero), _mm256_unpackhi_epi16(rh, zero)};
+
+              __m256i out[3];
+              out[0] = matrixRow(bgPairs, rPairs, cbg[0], cr[0], bias[0], shift);
+              if (uniform)
+              {
+                out[1] = out[2] = out[0];
+              }
+              else
+              {
+                out[1] = matrixRow(bgPairs, rPairs, cbg[1], cr[1], bias[1], shift);
+                out[2] = matrixRow(bgPairs, rPairs, cbg[2], cr[2], bias[2], shift);
+              }
+
+              uint8_t *d = dst + i * 3;
+              for (int chunk = 0; chunk < 3; chunk++)
+              {
+                __m256i v = gather3(out[0], out[1], out[2], masks.interleave[chunk]);
+                storeLanes(d + chunk * 16, d + 48 + chunk * 16, v);
+              }
+            }
+
+            colorMatrixScalar(src + i * 3, dst + i * 3, pixels - i, m);
+          }
+
+          void addSaturateAvx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n)
+          {
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+              __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+              __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_adds_epu8(va, vb));
+            }
+            addSaturateScalar(a + i, b + i, dst + i, n - i);
+          }
+
+          void addScalarSaturateAvx2(const uint8_t *src, uint8_t *dst, size_t n, int delta)
+          {
+            const bool add = delta >= 0;
+            const int magnitude = add ? delta : -delta;
+            const __m256i v = _mm256_set1_epi8(static_cast<char>(magnitude > 255 ? 255 : magnitude));
+
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+              __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+              __m256i r = add ? _mm256_adds_epu8(s, v) : _mm256_subs_epu8(s, v);
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), r);
+            }
+            addScalarSaturateScalar(src + i, dst + i, n - i, delta);
+          }
+
+          inline __m256i lowbias32(__m256i x)
+          {
+            x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+            x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+            x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+            x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+            return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+          }
+
+          inline __m256i noiseSamples(__m256i h, __m256i strength)
+          {
+            __m256i sum = _mm256_add_epi16(_mm256_and_si256(h, _mm256_set1_epi16(0xff)), _mm256_srli_epi16(h, 8));
+            return _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(sum, _mm256_set1_epi16(255)), strength), _mm256_set1_epi16(128)), 8);
+          }
+
+          void addNoiseAvx2(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength)
+          {
+            const __m256i s = _mm256_set1_epi16(static_cast<short>(strength));
+            size_t i = 0;
+
+            if ((index & 1) && n > 0)
+            {
+              addNoiseScalar(src, dst, 1, index, seed, strength);
+              i = 1;
+            }
+
+            while (i < n)
+            {
+              const uint64_t counter = (index + i) >> 1;
+              const size_t end = i + noiseRun(index + i, n - i);
+              const __m256i key = _mm256_set1_epi32(static_cast<int>(noiseKey(seed, static_cast<uint32_t>(counter >> 32))));
+              __m256i lo = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)),
+                                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+              for (; i + 32 <= end; i += 32)
+              {
+                __m256i h0 = lowbias32(_mm256_xor_si256(lo, key));
+                lo = _mm256_add_epi32(lo, _mm256_set1_epi32(8));
+                __m256i h1 = lowbias32(_mm256_xor_si256(lo, key));
+                lo = _mm256_add_epi32(lo, _mm256_set1_epi32(8));
+
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                __m256i a = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)), noiseSamples(h0, s));
+                __m256i b = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)), noiseSamples(h1, s));
+                // packus works per 128-bit lane; restore byte order across lanes.
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+              }
+
+              addNoiseScalar(src + i, dst + i, end - i, index + i, seed, strength);
+              i = end;
+            }
+          }
+
+          void scaleQ15Avx2(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale)
+          {
+            const __m256i s = _mm256_set1_epi16(static_cast<short>(scale));
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+              __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+              __m256i w0 = _mm256_mulhrs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i)), s);
+              __m256i w1 = _mm256_mulhrs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i + 16)), s);
+              __m256i a = _mm256_mulhrs_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)), w0);
+              __m256i b = _mm256_mulhrs_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)), w1);
+              __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+            }
+            scaleQ15Scalar(src + i, dst + i, n - i, weights + i, scale);
+          }
+
+          // Unpacks and packs both work within 128-bit lanes, so they cancel out
+          // and the bytes come back in order without a cross-lane permute.
+          void weightedRowsAvx2(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n)
+          {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i half = _mm256_set1_epi32(1 << (kFilterBits - 1));
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+              __m256i acc[4] = {half, half, half, half};
+              for (int k = 0; k < taps; k += 2)
+              {
+                const __m256i w = _mm256_set1_epi32(static_cast<int>(weightPair(weights, taps, k)));
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k + 1 < taps ? k + 1 : k] + i));
+                const __m256i lo = _mm256_unpacklo_epi8(a, b);
+                const __m256i hi = _mm256_unpackhi_epi8(a, b);
+                acc[0] = _mm256_add_epi32(acc[0], _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), w));
+                acc[1] = _mm256_add_epi32(acc[1], _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), w));
+                acc[2] = _mm256_add_epi32(acc[2], _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), w));
+                acc[3] = _mm256_add_epi32(acc[3], _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), w));
+              }
+              for (auto &v : acc)
+                v = _mm256_srai_epi32(v, kFilterBits);
+              const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(acc[0], acc[1]), _mm256_packs_epi32(acc[2], acc[3]));
+              _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+            }
+            weightedRowsRange(rows, weights, taps, dst, i, n);
+          }
+        }
+
+        const KernelTable *avx2Table()
+        {
+          static const KernelTable table{"avx2", colorMatrixAvx2, addSaturateAvx2, addScalarSaturateAvx2,
+                                         addNoiseAvx2, scaleQ15Avx2, weightedRowsAvx2};
+          return &table;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,259 @@
+#include "kernels.h"
+#include "shuffle_tables.h"
+#include <immintrin.h>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+      namespace detail
+      {
+        namespace
+        {
+          // Four independent 16-pixel groups, one per 128-bit lane (AVX-512BW).
+          inline __m512i mask(const int8_t (&bytes)[16])
+          {
+            return _mm512_broadcast_i32x4(_mm_load_si128(reinterpret_cast<const __m128i *>(bytes)));
+          }
+
+          inline __m512i loadLanes(const uint8_t *s)
+          {
+            __m512i v = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)));
+            v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 48)), 1);
+            v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 96)), 2);
+            v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 144)), 3);
+            return v;
+          }
+
+          inline void storeLanes(uint8_t *d, __m512i v)
+          {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm512_castsi512_si128(v));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 48), _mm512_extracti32x4_epi32(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 96), _mm512_extracti32x4_epi32(v, 2));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 144), _mm512_extracti32x4_epi32(v, 3));
+          }
+
+          inline __m512i gather3(__m512i c0, __m512i c1, __m512i c2, const int8_t (&m)[3][16])
+          {
+            return _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(c0, mask(m[0])),
+                                                   _mm512_shuffle_epi8(c1, mask(m[1]))),
+                                   _mm512_shuffle_epi8(c2, mask(m[2])));
+          }
+
+          inline __m512i matrixRow(const __m512i (&bg)[4], const __m512i (&r)[4],
+                                   __m512i cbg, __m512i cr, __m512i bias, __m128i shift)
+          {
+            __m512i acc[4];
+            for (int i = 0; i < 4; i++)
+            {
+              __m512i sum = _mm512_add_epi32(_mm512_madd_epi16(bg[i], cbg), _mm512_madd_epi16(r[i], cr));
+              acc[i] = _mm512_sra_epi32(_mm512_add_epi32(sum, bias), shift);
+            }
+            return _mm512_packus_epi16(_mm512_packs_epi32(acc[0], acc[1]), _mm512_packs_epi32(acc[2], acc[3]));
+          }
+
+          void colorMatrixAvx512(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m)
+          {
+            const auto &masks = kBgrShuffleMasks;
+            const __m512i zero = _mm512_setzero_si512();
+            const __m128i shift = _mm_cvtsi32_si128(m.shift);
+            const bool uniform = m.uniformRows();
+
+            __m512i cbg[3], cr[3], bias[3];
+            for (int k = 0; k < 3; k++)
+            {
+              uint32_t pair = (static_cast<uint32_t>(static_cast<uint16_t>(m.coeffs[k][1])) << 16) |
+                              static_cast<uint16_t>(m.coeffs[k][0]);
+              cbg[k] = _mm512_set1_epi32(static_cast<int32_t>(pair));
+              cr[k] = _mm512_set1_epi32(static_cast<uint16_t>(m.coeffs[k][2]));
+              bias[k] = _mm512_set1_epi32(m.bias[k]);
+            }
+
+            size_t i = 0;
+            for (; i + 64 <= pixels; i += 64)
+            {
+              const uint8_t *s = src + i * 3;
+              __m512i c0 = loadLanes(s);
+              __m512i c1 = loadLanes(s + 16);
+              __m512i c2 = loadLanes(s + 32);
+
+              __m512i b = gather3(c0, c1, c2, masks.deinterleave[0]);
+              __m512i g = gather3(c0, c1, c2, masks.deinterleave[1]);
+              __m512i r = gather3(c0, c1, c2, masks.deinterleave[2]);
+
+              __m512i bl = _mm512_unpacklo_epi8(b, zero), bh = _mm512_unpackhi_epi8(b, zero);
+              __m512i gl = _mm512_unpacklo_epi8(g, zero), gh = _mm512_unpackhi_epi8(g, zero);
+              __m512i rl = _mm512_unpacklo_epi8(r, zero), rh = _mm512_unpackhi_epi8(r, zero);
+
+              const __m512i bgPairs[4] = {_mm512_unpacklo_epi16(bl, gl), _mm512_unpackhi_epi16(bl, gl),
+                                          _mm512_unpacklo_epi16(bh, gh), _mm512_unpackhi_epi16(bh, gh)};
+              const __m512i rPairs[4] = {_mm512_unpacklo_epi16(rl, zero), _mm512_unpackhi_epi16(rl, zero),
+                                         _mm512_unpacklo_epi16(rh, zero), _mm512_unpackhi_epi16(rh, zero)};
+
+              __m512i out[3];
+              out[0] = matrixRow(bgPairs, rPairs, cbg[0], cr[0], bias[0], shift);
+              if (uniform)
+              {
+                out[1] = out[2] = out[0];
+              }
+              else
+              {
+                out[1] = matrixRow(bgPairs, rPairs, cbg[1], cr[1], bias[1], shift);
+                out[2] = matrixRow(bgPairs, rPairs, cbg[2], cr[2], bias[2], shift);
+              }
+
+              uint8_t *d = dst + i * 3;
+              for (int chunk = 0; chunk < 3; chunk++)
+                storeLanes(d + chunk * 16, gather3(out[0], out[1], out[2], masks.interleave[chunk]));
+            }
+
+            colorMatrixScalar(src + i * 3, dst + i * 3, pixels - i, m);
+          }
+
+          void addSaturateAvx512(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n)
+          {
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+              __m512i va = _mm512_loadu_si512(a + i);
+              __m512i vb = _mm512_loadu_si512(b + i);
+              _mm512_storeu_si512(dst + i, _mm512_adds_epu8(va, vb));
+            }
+            addSaturateScalar(a + i, b + i, dst + i, n - i);
+          }
+
+          void addScalarSaturateAvx512(const uint8_t *src, uint8_t *dst, size_t n, int delta)
+          {
+            const bool add = delta >= 0;
+            const int magnitude = add ? delta : -delta;
+            const __m512i v = _mm512_set1_epi8(static_cast<char>(magnitude > 255 ? 255 : magnitude));
+
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+              __m512i s = _mm512_loadu_si512(src + i);
+              __m512i r = add ? _mm512_adds_epu8(s, v) : _mm512_subs_epu8(s, v);
+              _mm512_storeu_si512(dst + i, r);
+            }
+            addScalarSaturateScalar(src + i, dst + i, n - i, delta);
+          }
+
+          inline __m512i lowbias32(__m512i x)
+          {
+            x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+            x = _mm512_mullo_epi32(x, _mm512_set1_epi32(0x7feb352d));
+            x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 15));
+            x = _mm512_mullo_epi32(x, _mm512_set1_epi32(static_cast<int>(0x846ca68bu)));
+            return _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+          }
+
+          inline __m512i noiseSamples(__m512i h, __m512i strength)
+          {
+            __m512i sum = _mm512_add_epi16(_mm512_and_si512(h, _mm512_set1_epi16(0xff)), _mm512_srli_epi16(h, 8));
+            return _mm512_srai_epi16(_mm512_add_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(sum, _mm512_set1_epi16(255)), strength), _mm512_set1_epi16(128)), 8);
+          }
+
+          // Clamps 32 signed 16-bit sums to [0, 255] and narrows them in order.
+          inline __m256i narrowClamped(__m512i v)
+          {
+            return _mm512_cvtusepi16_epi8(_mm512_max_epi16(v, _mm512_setzero_si512()));
+          }
+
+          void addNoiseAvx512(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength)
+          {
+            const __m512i s = _mm512_set1_epi16(static_cast<short>(strength));
+            size_t i = 0;
+
+            if ((index & 1) && n > 0)
+            {
+              addNoiseScalar(src, dst, 1, index, seed, strength);
+              i = 1;
+            }
+
+            while (i < n)
+            {
+              const uint64_t counter = (index + i) >> 1;
+              const size_t end = i + noiseRun(index + i, n - i);
+              const __m512i key = _mm512_set1_epi32(static_cast<int>(noiseKey(seed, static_cast<uint32_t>(counter >> 32))));
+              __m512i lo = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(counter)),
+                                            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+              for (; i + 64 <= end; i += 64)
+              {
+                __m512i h0 = lowbias32(_mm512_xor_si512(lo, key));
+                lo = _mm512_add_epi32(lo, _mm512_set1_epi32(16));
+                __m512i h1 = lowbias32(_mm512_xor_si512(lo, key));
+                lo = _mm512_add_epi32(lo, _mm512_set1_epi32(16));
+
+                __m512i v = _mm512_loadu_si512(src + i);
+                __m512i a = _mm512_add_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(v)), noiseSamples(h0, s));
+                __m512i b = _mm512_add_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(v, 1)), noiseSamples(h1, s));
+                __m512i packed = _mm512_inserti64x4(_mm512_castsi256_si512(narrowClamped(a)), narrowClamped(b), 1);
+                _mm512_storeu_si512(dst + i, packed);
+              }
+
+              addNoiseScalar(src + i, dst + i, end - i, index + i, seed, strength);
+              i = end;
+            }
+          }
+
+          void scaleQ15Avx512(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale)
+          {
+            const __m512i s = _mm512_set1_epi16(static_cast<short>(scale));
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+              __m512i w0 = _mm512_mulhrs_epi16(_mm512_loadu_si512(weights + i), s);
+              __m512i w1 = _mm512_mulhrs_epi16(_mm512_loadu_si512(weights + i + 32), s);
+              __m512i a = _mm512_mulhrs_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i))), w0);
+              __m512i b = _mm512_mulhrs_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32))), w1);
+              // Products never exceed 255, so plain truncation narrows them.
+              __m512i packed = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi16_epi8(a)), _mm512_cvtepi16_epi8(b), 1);
+              _mm512_storeu_si512(dst + i, packed);
+            }
+            scaleQ15Scalar(src + i, dst + i, n - i, weights + i, scale);
+          }
+
+          // Unpacks and packs both work within 128-bit lanes, so they cancel out
+          // and the bytes come back in order without a cross-lane permute.
+          void weightedRowsAvx512(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n)
+          {
+            const __m512i zero = _mm512_setzero_si512();
+            const __m512i half = _mm512_set1_epi32(1 << (kFilterBits - 1));
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+              __m512i acc[4] = {half, half, half, half};
+              for (int k = 0; k < taps; k += 2)
+              {
+                const __m512i w = _mm512_set1_epi32(static_cast<int>(weightPair(weights, taps, k)));
+                const __m512i a = _mm512_loadu_si512(rows[k] + i);
+                const __m512i b = _mm512_loadu_si512(rows[k + 1 < taps ? k + 1 : k] + i);
+                const __m512i lo = _mm512_unpacklo_epi8(a, b);
+                const __m512i hi = _mm512_unpackhi_epi8(a, b);
+                acc[0] = _mm512_add_epi32(acc[0], _mm512_madd_epi16(_mm512_unpacklo_epi8(lo, zero), w));
+                acc[1] = _mm512_add_epi32(acc[1], _mm512_madd_epi16(_mm512_unpackhi_epi8(lo, zero), w));
+                acc[2] = _mm512_add_epi32(acc[2], _mm512_madd_epi16(_mm512_unpacklo_epi8(hi, zero), w));
+                acc[3] = _mm512_add_epi32(acc[3], _mm512_madd_epi16(_mm512_unpackhi_epi8(hi, zero), w));
+              }
+              for (auto &v : acc)
+                v = _mm512_srai_epi32(v, kFilterBits);
+              const __m512i packed = _mm512_packus_epi16(_mm512_packs_epi32(acc[0], acc[1]), _mm512_packs_epi32(acc[2], acc[3]));
+              _mm512_storeu_si512(dst + i, packed);
+            }
+            weightedRowsRange(rows, weights, taps, dst, i, n);
+          }
+        }
+
+        const KernelTable *avx512Table()
+        {
+          static const KernelTable table{"avx512", colorMatrixAvx512, addSaturateAvx512, addScalarSaturateAvx512,
+                                         addNoiseAvx512, scaleQ15Avx512, weightedRowsAvx512};
+          return &table;
+        }
+      }
+    }
+  }
+}
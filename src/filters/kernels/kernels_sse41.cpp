@@ -0,0 +1,235 @@
+#include "kernels.h"
+#include "shuffle_tables.h"
+#include <immintrin.h>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+      namespace detail
+      {
+        namespace
+        {
+          inline __m128i mask(const int8_t (&bytes)[16])
+          {
+            return _mm_load_si128(reinterpret_cast<const __m128i *>(bytes));
+          }
+
+          inline __m128i gather3(__m128i c0, __m128i c1, __m128i c2, const int8_t (&m)[3][16])
+          {
+            return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, mask(m[0])),
+                                             _mm_shuffle_epi8(c1, mask(m[1]))),
+                                _mm_shuffle_epi8(c2, mask(m[2])));
+          }
+
+          inline __m128i matrixRow(const __m128i (&bg)[4], const __m128i (&r)[4],
+                                   __m128i cbg, __m128i cr, __m128i bias, __m128i shift)
+          {
+            __m128i acc[4];
+            for (int i = 0; i < 4; i++)
+            {
+              __m128i sum = _mm_add_epi32(_mm_madd_epi16(bg[i], cbg), _mm_madd_epi16(r[i], cr));
+              acc[i] = _mm_sra_epi32(_mm_add_epi32(sum, bias), shift);
+            }
+            return _mm_packus_epi16(_mm_packs_epi32(acc[0], acc[1]), _mm_packs_epi32(acc[2], acc[3]));
+          }
+
+          void colorMatrixSse41(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m)
+          {
+            const auto &masks = kBgrShuffleMasks;
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i shift = _mm_cvtsi32_si128(m.shift);
+            const bool uniform = m.uniformRows();
+
+            __m128i cbg[3], cr[3], bias[3];
+            for (int k = 0; k < 3; k++)
+            {
+              uint32_t pair = (static_cast<uint32_t>(static_cast<uint16_t>(m.coeffs[k][1])) << 16) |
+                              static_cast<uint16_t>(m.coeffs[k][0]);
+              cbg[k] = _mm_set1_epi32(static_cast<int32_t>(pair));
+              cr[k] = _mm_set1_epi32(static_cast<uint16_t>(m.coeffs[k][2]));
+              bias[k] = _mm_set1_epi32(m.bias[k]);
+            }
+
+            size_t i = 0;
+            for (; i + 16 <= pixels; i += 16)
+            {
+              const uint8_t *s = src + i * 3;
+              __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+              __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 16));
+              __m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 32));
+
+              __m128i b = gather3(c0, c1, c2, masks.deinterleave[0]);
+              __m128i g = gather3(c0, c1, c2, masks.deinterleave[1]);
+              __m128i r = gather3(c0, c1, c2, masks.deinterleave[2]);
+
+              __m128i bl = _mm_unpacklo_epi8(b, zero), bh = _mm_unpackhi_epi8(b, zero);
+              __m128i gl = _mm_unpacklo_epi8(g, zero), gh = _mm_unpackhi_epi8(g, zero);
+              __m128i rl = _mm_unpacklo_epi8(r, zero), rh = _mm_unpackhi_epi8(r, zero);
+
+              const __m128i bgPairs[4] = {_mm_unpacklo_epi16(bl, gl), _mm_unpackhi_epi16(bl, gl),
+                                          _mm_unpacklo_epi16(bh, gh), _mm_unpackhi_epi16(bh, gh)};
+              const __m128i rPairs[4] = {_mm_unpacklo_epi16(rl, zero), _mm_unpackhi_epi16(rl, zero),
+                                         _mm_unpacklo_epi16(rh, zero), _mm_unpackhi_epi16(rh, zero)};
+
+              __m128i out[3];
+              out[0] = matrixRow(bgPairs, rPairs, cbg[0], cr[0], bias[0], shift);
+              if (uniform)
+              {
+                out[1] = out[2] = out[0];
+              }
+              else
+              {
+                out[1] = matrixRow(bgPairs, rPairs, cbg[1], cr[1], bias[1], shift);
+                out[2] = matrixRow(bgPairs, rPairs, cbg[2], cr[2], bias[2], shift);
+              }
+
+              uint8_t *d = dst + i * 3;
+              for (int chunk = 0; chunk < 3; chunk++)
+              {
+                __m128i v = gather3(out[0], out[1], out[2], masks.interleave[chunk]);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(d + chunk * 16), v);
+              }
+            }
+
+            colorMatrixScalar(src + i * 3, dst + i * 3, pixels - i, m);
+          }
+
+          void addSaturateSse41(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n)
+          {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+              __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+              __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_adds_epu8(va, vb));
+            }
+            addSaturateScalar(a + i, b + i, dst + i, n - i);
+          }
+
+          void addScalarSaturateSse41(const uint8_t *src, uint8_t *dst, size_t n, int delta)
+          {
+            const bool add = delta >= 0;
+            const int magnitude = add ? delta : -delta;
+            const __m128i v = _mm_set1_epi8(static_cast<char>(magnitude > 255 ? 255 : magnitude));
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+              __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+              __m128i r = add ? _mm_adds_epu8(s, v) : _mm_subs_epu8(s, v);
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), r);
+            }
+            addScalarSaturateScalar(src + i, dst + i, n - i, delta);
+          }
+
+          inline __m128i lowbias32(__m128i x)
+          {
+            x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+            x = _mm_mullo_epi32(x, _mm_set1_epi32(0x7feb352d));
+            x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+            x = _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+            return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+          }
+
+          // Eight 16-bit hash halves -> eight noise samples, as in noiseSample().
+          inline __m128i noiseSamples(__m128i h, __m128i strength)
+          {
+            __m128i sum = _mm_add_epi16(_mm_and_si128(h, _mm_set1_epi16(0xff)), _mm_srli_epi16(h, 8));
+            return _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(sum, _mm_set1_epi16(255)), strength), _mm_set1_epi16(128)), 8);
+          }
+
+          void addNoiseSse41(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength)
+          {
+            const __m128i s = _mm_set1_epi16(static_cast<short>(strength));
+            size_t i = 0;
+
+            // Blocks start on an even index so each hash feeds two whole bytes.
+            if ((index & 1) && n > 0)
+            {
+              addNoiseScalar(src, dst, 1, index, seed, strength);
+              i = 1;
+            }
+
+            while (i < n)
+            {
+              const uint64_t counter = (index + i) >> 1;
+              const size_t end = i + noiseRun(index + i, n - i);
+              const __m128i key = _mm_set1_epi32(static_cast<int>(noiseKey(seed, static_cast<uint32_t>(counter >> 32))));
+              __m128i lo = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter)), _mm_setr_epi32(0, 1, 2, 3));
+
+              for (; i + 16 <= end; i += 16)
+              {
+                __m128i h0 = lowbias32(_mm_xor_si128(lo, key));
+                lo = _mm_add_epi32(lo, _mm_set1_epi32(4));
+                __m128i h1 = lowbias32(_mm_xor_si128(lo, key));
+                lo = _mm_add_epi32(lo, _mm_set1_epi32(4));
+
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                __m128i a = _mm_add_epi16(_mm_cvtepu8_epi16(v), noiseSamples(h0, s));
+                __m128i b = _mm_add_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(v, 8)), noiseSamples(h1, s));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+              }
+
+              addNoiseScalar(src + i, dst + i, end - i, index + i, seed, strength);
+              i = end;
+            }
+          }
+
+          void scaleQ15Sse41(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale)
+          {
+            const __m128i s = _mm_set1_epi16(static_cast<short>(scale));
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+              __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+              __m128i w0 = _mm_mulhrs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i)), s);
+              __m128i w1 = _mm_mulhrs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i + 8)), s);
+              __m128i a = _mm_mulhrs_epi16(_mm_cvtepu8_epi16(v), w0);
+              __m128i b = _mm_mulhrs_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(v, 8)), w1);
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+            }
+            scaleQ15Scalar(src + i, dst + i, n - i, weights + i, scale);
+          }
+
+          void weightedRowsSse41(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n)
+          {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i half = _mm_set1_epi32(1 << (kFilterBits - 1));
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+              __m128i acc[4] = {half, half, half, half};
+              for (int k = 0; k < taps; k += 2)
+              {
+                const __m128i w = _mm_set1_epi32(static_cast<int>(weightPair(weights, taps, k)));
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1 < taps ? k + 1 : k] + i));
+                const __m128i lo = _mm_unpacklo_epi8(a, b);
+                const __m128i hi = _mm_unpackhi_epi8(a, b);
+                acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+                acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+                acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+                acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+              }
+              for (auto &v : acc)
+                v = _mm_srai_epi32(v, kFilterBits);
+              const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc[0], acc[1]), _mm_packs_epi32(acc[2], acc[3]));
+              _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+            }
+            weightedRowsRange(rows, weights, taps, dst, i, n);
+          }
+        }
+
+        const KernelTable *sse41Table()
+        {
+          static const KernelTable table{"sse41", colorMatrixSse41, addSaturateSse41, addScalarSaturateSse41,
+                                         addNoiseSse41, scaleQ15Sse41, weightedRowsSse41};
+          return &table;
+        }
+      }
+    }
+  }
+}
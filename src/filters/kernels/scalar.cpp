@@ -0,0 +1,128 @@
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+
+      ColorMatrix ColorMatrix::fromFloat(const float matrix[3][3], const float offset[3], int shift)
+      {
+        ColorMatrix m{};
+        m.shift = shift;
+        const float scale = static_cast<float>(1 << shift);
+
+        for (int k = 0; k < 3; k++)
+        {
+          for (int j = 0; j < 3; j++)
+          {
+            long c = std::lround(matrix[k][j] * scale);
+            m.coeffs[k][j] = static_cast<int16_t>(std::clamp<long>(c, INT16_MIN, INT16_MAX));
+          }
+          float off = offset ? offset[k] : 0.0f;
+          m.bias[k] = static_cast<int32_t>(std::lround(off * scale)) + (1 << (shift - 1));
+        }
+
+        return m;
+      }
+
+      ColorMatrix ColorMatrix::sepia()
+      {
+        static const float matrix[3][3] = {
+            {0.131f, 0.534f, 0.272f},
+            {0.168f, 0.686f, 0.349f},
+            {0.189f, 0.769f, 0.393f},
+        };
+        return fromFloat(matrix);
+      }
+
+      ColorMatrix ColorMatrix::gray()
+      {
+        // cv::cvtColor's Q14 BGR2GRAY weights, replicated into all three rows.
+        ColorMatrix m{};
+        m.shift = 14;
+        for (int k = 0; k < 3; k++)
+        {
+          m.coeffs[k][0] = 1868;
+          m.coeffs[k][1] = 9617;
+          m.coeffs[k][2] = 4899;
+          m.bias[k] = 1 << 13;
+        }
+        return m;
+      }
+
+      bool ColorMatrix::uniformRows() const
+      {
+        for (int k = 1; k < 3; k++)
+        {
+          if (bias[k] != bias[0])
+            return false;
+          for (int j = 0; j < 3; j++)
+            if (coeffs[k][j] != coeffs[0][j])
+              return false;
+        }
+        return true;
+      }
+
+      namespace detail
+      {
+        void colorMatrixScalar(const uint8_t *src, uint8_t *dst, size_t pixels, const ColorMatrix &m)
+        {
+          for (size_t i = 0; i < pixels; i++)
+            colorMatrixPixel(src + i * 3, dst + i * 3, m);
+        }
+
+        void addSaturateScalar(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t n)
+        {
+          for (size_t i = 0; i < n; i++)
+          {
+            int v = a[i] + b[i];
+            dst[i] = static_cast<uint8_t>(v > 255 ? 255 : v);
+          }
+        }
+
+        void addScalarSaturateScalar(const uint8_t *src, uint8_t *dst, size_t n, int delta)
+        {
+          for (size_t i = 0; i < n; i++)
+            dst[i] = static_cast<uint8_t>(std::clamp(src[i] + delta, 0, 255));
+        }
+
+        void addNoiseScalar(const uint8_t *src, uint8_t *dst, size_t n, uint64_t index, uint32_t seed, int strength)
+        {
+          for (size_t i = 0; i < n; i++)
+            dst[i] = static_cast<uint8_t>(std::clamp(src[i] + noiseSample(index + i, seed, strength), 0, 255));
+        }
+
+        void scaleQ15Scalar(const uint8_t *src, uint8_t *dst, size_t n, const int16_t *weights, int scale)
+        {
+          for (size_t i = 0; i < n; i++)
+            dst[i] = static_cast<uint8_t>(mulQ15(src[i], mulQ15(weights[i], scale)));
+        }
+
+        void weightedRowsScalar(const uint8_t *const *rows, const int16_t *weights, int taps, uint8_t *dst, size_t n)
+        {
+          weightedRowsRange(rows, weights, taps, dst, 0, n);
+        }
+      }
+
+      void applyLut(const uint8_t *src, uint8_t *dst, size_t n, const Lut &lut)
+      {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+          const uint8_t a = lut[src[i]], b = lut[src[i + 1]], c = lut[src[i + 2]], d = lut[src[i + 3]];
+          dst[i] = a;
+          dst[i + 1] = b;
+          dst[i + 2] = c;
+          dst[i + 3] = d;
+        }
+        for (; i < n; i++)
+          dst[i] = lut[src[i]];
+      }
+
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// pshufb control masks for splitting 16 interleaved BGR pixels (three 16-byte
+// chunks) into B, G and R planes and merging them back. The vector kernels
+// apply them per 128-bit lane, so wider ISAs process several 16-pixel groups
+// side by side with the same masks.
+
+namespace imagetui
+{
+  namespace filters
+  {
+    namespace kernels
+    {
+      namespace detail
+      {
+
+        struct BgrShuffleMasks
+        {
+          // deinterleave[plane][chunk]: picks this chunk's bytes of `plane`.
+          alignas(16) int8_t deinterleave[3][3][16];
+          // interleave[chunk][plane]: places `plane` bytes into output `chunk`.
+          alignas(16) int8_t interleave[3][3][16];
+        };
+
+        constexpr BgrShuffleMasks makeBgrShuffleMasks()
+        {
+          BgrShuffleMasks masks{};
+
+          for (int plane = 0; plane < 3; plane++)
+            for (int chunk = 0; chunk < 3; chunk++)
+              for (int p = 0; p < 16; p++)
+              {
+                int g = p * 3 + plane;
+                masks.deinterleave[plane][chunk][p] =
+                    static_cast<int8_t>(g / 16 == chunk ? g % 16 : -1);
+              }
+
+          for (int chunk = 0; chunk < 3; chunk++)
+            for (int plane = 0; plane < 3; plane++)
+              for (int j = 0; j < 16; j++)
+              {
+                int g = chunk * 16 + j;
+                masks.interleave[chunk][plane][j] =
+                    static_cast<int8_t>(g % 3 == plane ? g / 3 : -1);
+              }
+
+          return masks;
+        }
+
+        inline constexpr BgrShuffleMasks kBgrShuffleMasks = makeBgrShuffleMasks();
+
+      }
+    }
+  }
+}
@@ -0,0 +1,247 @@
+#include "filters/registry.h"
+#include "filters/artistic.h"
+#include "filters/basic.h"
+#include "filters/color.h"
+#include "filters/enhancement.h"
+#include "filters/geometric.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace imagetui
+{
+  namespace filters
+  {
+
+    namespace
+    {
+      std::vector<std::string> split(const std::string &text, char separator)
+      {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, separator))
+          parts.push_back(part);
+        return parts;
+      }
+
+      bool parseInt(const std::string &text, int &value)
+      {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && end == text.data() + text.size();
+      }
+
+      bool parseFloat(const std::string &text, float &value)
+      {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && end == text.data() + text.size() && std::isfinite(value);
+      }
+
+      // Parses a single float argument within [low, high].
+      bool floatArg(const std::vector<std::string> &args, float low, float high, float &value)
+      {
+        return args.size() == 1 && parseFloat(args[0], value) && value >= low && value <= high;
+      }
+    }
+
+    const std::vector<FilterInfo> &FilterRegistry::filters()
+    {
+      static const std::vector<FilterInfo> registry = {
+          {"grayscale", "grayscale", {}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             pipeline.then(BasicFilters::grayscaleOp());
+             return args.empty();
+           }},
+          {"sepia", "sepia", {}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             pipeline.then(ArtisticFilters::sepiaOp());
+             return args.empty();
+           }},
+          {"vignette", "vignette[:strength]", {"0.80"}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             float strength;
+             if (!floatArg(args, 0.0f, 1.0f, strength))
+               return false;
+             pipeline.then(ArtisticFilters::vignetteOp(strength));
+             return true;
+           }},
+          {"invert", "invert", {}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             pipeline.then(ColorFilters::invertOp());
+             return args.empty();
+           }},
+          {"brightness", "brightness[:delta]", {"20"}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             int delta;
+             if (args.size() != 1 || !parseInt(args[0], delta) || delta < -255 || delta > 255)
+               return false;
+             pipeline.then(ColorFilters::brightnessOp(delta));
+             return true;
+           }},
+          {"contrast", "contrast[:factor]", {"1.20"}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             float factor;
+             if (!floatArg(args, 0.0f, 4.0f, factor))
+               return false;
+             pipeline.then(EnhancementFilters::contrastOp(factor));
+             return true;
+           }},
+          {"gamma", "gamma[:gamma]", {"1.20"}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             float gamma;
+             if (!floatArg(args, 0.1f, 10.0f, gamma))
+               return false;
+             pipeline.then(EnhancementFilters::gammaOp(gamma));
+             return true;
+           }},
+          {"mirror", "mirror", {}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             pipeline.thenNeighborhood(GeometricFilters::mirrorOp(), 0);
+             return args.empty();
+           }},
+          {"noise", "noise[:strength[:seed]]", {"25", "0"}, {},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             int strength, seed;
+             if (args.size() != 2 || !parseInt(args[0], strength) || !parseInt(args[1], seed) ||
+                 strength < 0 || strength > 127 || seed < 0)
+               return false;
+             pipeline.then(ArtisticFilters::noiseOp(strength, static_cast<uint32_t>(seed)));
+             return true;
+           }},
+          {"oil", "oil[:radius[:intensity]]", {"3", "20"}, {0},
+           [](core::Pipeline &pipeline, const std::vector<std::string> &args)
+           {
+             int radius, intensity;
+             if (args.size() != 2 || !parseInt(args[0], radius) || !parseInt(args[1], intensity) || radius < 1 ||
+                 radius > ArtisticFilters::kMaxOilRadius)
+               return false;
+             pipeline.thenNeighborhood(ArtisticFilters::oilPaintingOp(radius, intensity), radius);
+             return true;
+           }},
+      };
+      return registry;
+    }
+
+    const FilterInfo *FilterRegistry::find(const std::string &name)
+    {
+      for (const auto &info : filters())
+      {
+        if (info.name == name)
+          return &info;
+      }
+      return nullptr;
+    }
+
+    bool FilterRegistry::parseChain(const std::string &spec, std::vector<Stage> &stages)
+    {
+      for (const auto &text : split(spec, ','))
+      {
+        auto args = split(text, ':');
+        if (args.empty() || args[0].empty())
+        {
+          std::cerr << "Error: Empty filter in chain: " << spec << std::endl;
+          return false;
+        }
+
+        std::string name = args[0];
+        args.erase(args.begin());
+
+        const FilterInfo *info = find(name);
+        if (!info)
+        {
+          std::cerr << "Error: Unknown filter: " << name << std::endl;
+          return false;
+        }
+
+        if (args.size() > info->defaults.size())
+        {
+          std::cerr << "Error: Bad arguments for " << name << ", usage: " << info->usage << std::endl;
+          return false;
+        }
+
+        for (size_t i = args.size(); i < info->defaults.size(); i++)
+          args.push_back(info->defaults[i]);
+
+        stages.push_back(Stage{info, std::move(args)});
+      }
+
+      return true;
+    }
+
+    bool FilterRegistry::buildPipeline(const std::string &spec, core::Pipeline &pipeline, double scale)
+    {
+      std::vector<Stage> stages;
+      if (!parseChain(spec, stages))
+        return false;
+
+      for (auto &stage : stages)
+      {
+        for (size_t index : stage.info->pixelArgs)
+        {
+          int value;
+          if (scale != 1.0 && index < stage.args.size() && parseInt(stage.args[index], value))
+            stage.args[index] = std::to_string(std::max(1, static_cast<int>(std::lround(value * scale))));
+        }
+
+        if (!stage.info->append(pipeline, stage.args))
+        {
+          std::cerr << "Error: Bad arguments for " << stage.info->name << ", usage: " << stage.info->usage << std::endl;
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool FilterRegistry::canonicalSpec(const std::string &spec, std::string &canonical)
+    {
+      std::vector<Stage> stages;
+      if (!parseChain(spec, stages))
+        return false;
+
+      canonical.clear();
+      for (const auto &stage : stages)
+      {
+        if (!canonical.empty())
+          canonical += ',';
+        canonical += stage.info->name;
+
+        for (const auto &arg : stage.args)
+        {
+          int value;
+          float real;
+          canonical += ':';
+          if (parseInt(arg, value))
+          {
+            canonical += std::to_string(value);
+          }
+          else if (parseFloat(arg, real))
+          {
+            // Shortest round-trip form, so "0.80" and "0.8" share a key.
+            char text[32];
+            auto result = std::to_chars(text, text + sizeof(text), real);
+            canonical.append(text, result.ptr);
+          }
+          else
+          {
+            canonical += arg;
+          }
+        }
+      }
+
+      return true;
+    }
+
+  }
+}
@@ -1,16 +1,273 @@
 #include <iostream>
 #include <chrono>
 #include <iomanip>
+#include <cstdio>
+#include <cstdlib>
 #include "core/image_processor.h"
+#include "core/batch_processor.h"
+#include "core/result_cache.h"
+#include "core/stream_processor.h"
 #include "filters/basic.h"
+#include "filters/geometric.h"
+#include "filters/registry.h"
+#include "ui/tui.h"
+#include "utils/utility.h"
 
 using namespace imagetui;
 
-int main(int argc, char *argv[])
+static void printUsage(const char *program)
+{
+  std::cerr << "Usage: " << program << " <input_image> <output_image>" << std::endl;
+  std::cerr << "       " << program << " --batch <input_dir> <output_dir> [options]" << std::endl;
+  std::cerr << "       " << program << " --stream <input_image> <output_image> [--filter <chain>] [--strip <rows>]"
+            << " [--quality <0-100>]" << std::endl;
+  std::cerr << "       " << program << " --tui <input_image> [output_image] [--filter <name>]" << std::endl;
+  std::cerr << "       Any mode also takes --trace <file.json> (Chrome trace-event format)" << std::endl;
+  std::cerr << "       Single and --batch runs take --cache-dir <dir> [--cache-mb <n>] to reuse earlier results"
+            << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "Batch options:" << std::endl;
+  std::cerr << "  --filter <chain>     Filter chain, e.g. sepia,oil:5:20 (default: grayscale)" << std::endl;
+  std::cerr << "  --format <ext>       Output format (default: same as input)" << std::endl;
+  std::cerr << "  --max-size <WxH>     Shrink to fit before filtering; JPEGs decode at reduced scale" << std::endl;
+  std::cerr << "  --quality <0-100>    Encoder quality (default: 85)" << std::endl;
+  std::cerr << "  --min-quality <n>    Lowest quality lossy output may drop to under --max-bytes" << std::endl;
+  std::cerr << "  --max-encode-ms <ms> Encode time budget per image" << std::endl;
+  std::cerr << "  --max-bytes <n>      Output size budget per image" << std::endl;
+  std::cerr << "  --threads <d:f:e>    Decode/filter/encode worker counts" << std::endl;
+  std::cerr << "  --queue <n>          Frames buffered between stages (default: 4)" << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "Filters:";
+  for (const auto &info : filters::FilterRegistry::filters())
+    std::cerr << " " << info.usage;
+  std::cerr << std::endl;
+}
+
+static void printCacheStats(const core::ResultCache *cache)
+{
+  if (!cache)
+    return;
+
+  auto stats = cache->stats();
+  std::cout << "Cache: " << stats.memoryHits << " memory / " << stats.diskHits << " disk hits, "
+            << stats.misses << " misses, " << stats.memoryEvictions + stats.diskEvictions << " evictions, "
+            << (stats.diskBytes >> 20) << " MB on disk" << std::endl;
+}
+
+static int runBatch(int argc, char *argv[], core::ResultCache *cache)
+{
+  if (argc < 4)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  core::BatchOptions options;
+  options.inputDir = argv[2];
+  options.outputDir = argv[3];
+  std::string chain = "grayscale";
+  cv::Size maxSize;
+
+  for (int i = 4; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+    {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return 1;
+    }
+
+    std::string value = argv[++i];
+    if (arg == "--filter")
+      chain = value;
+    else if (arg == "--format")
+      options.outputFormat = value;
+    else if (arg == "--max-size")
+    {
+      if (std::sscanf(value.c_str(), "%dx%d", &maxSize.width, &maxSize.height) != 2 ||
+          maxSize.width <= 0 || maxSize.height <= 0)
+      {
+        std::cerr << "Bad --max-size value, expected WxH" << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--quality")
+      options.encode.quality = std::atoi(value.c_str());
+    else if (arg == "--min-quality")
+      options.encode.minQuality = std::atoi(value.c_str());
+    else if (arg == "--max-encode-ms")
+      options.encode.maxEncodeMs = std::atof(value.c_str());
+    else if (arg == "--max-bytes")
+      options.encode.maxBytes = std::strtoull(value.c_str(), nullptr, 10);
+    else if (arg == "--queue")
+      options.queueCapacity = std::atoi(value.c_str());
+    else if (arg == "--threads")
+    {
+      if (std::sscanf(value.c_str(), "%d:%d:%d", &options.decodeThreads,
+                      &options.filterThreads, &options.encodeThreads) != 3)
+      {
+        std::cerr << "Bad --threads value, expected decode:filter:encode" << std::endl;
+        return 1;
+      }
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  core::Pipeline pipeline;
+  if (!filters::FilterRegistry::buildPipeline(chain, pipeline))
+    return 1;
+
+  options.cache = cache;
+  filters::FilterRegistry::canonicalSpec(chain, options.chainKey);
+
+  if (!maxSize.empty())
+  {
+    options.load = [maxSize](const std::string &path)
+    { return filters::GeometricFilters::loadFitted(path, maxSize); };
+    // The fit changes the result, so it is part of the cache key too.
+    options.chainKey = "fit:" + std::to_string(maxSize.width) + "x" + std::to_string(maxSize.height) + "," +
+                       options.chainKey;
+  }
+
+  std::cout << "Batch: " << options.inputDir << " -> " << options.outputDir
+            << " [" << chain << "]" << std::endl;
+
+  core::BatchStats stats = core::BatchProcessor::run(options, pipeline);
+
+  std::cout << "Processed: " << stats.processed << " (" << stats.cached << " from cache) | Failed: " << stats.failed
+            << " | Peak frames in memory: " << stats.peakFramesInFlight << std::endl;
+  std::cout << std::fixed << std::setprecision(1)
+            << "Busy time - Decode: " << stats.decodeSeconds << "s | Filter: " << stats.filterSeconds
+            << "s | Encode: " << stats.encodeSeconds << "s" << std::endl;
+  std::cout << "Total: " << stats.wallSeconds << "s for " << stats.megapixels << " MP" << std::endl;
+  std::cout << "Speed: " << stats.megapixelsPerSecond() << " MP/sec" << std::endl;
+
+  auto pool = core::BufferPool::instance().stats();
+  std::cout << "Buffer pool: " << pool.hits << " reused / " << pool.misses << " allocated, "
+            << (pool.retainedBytes >> 20) << " MB retained" << std::endl;
+  printCacheStats(cache);
+
+  return stats.failed == 0 ? 0 : 1;
+}
+
+static int runStream(int argc, char *argv[])
+{
+  if (argc < 4)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  core::StreamOptions options;
+  std::string chain = "grayscale";
+
+  for (int i = 4; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+    {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return 1;
+    }
+
+    std::string value = argv[++i];
+    if (arg == "--filter")
+      chain = value;
+    else if (arg == "--strip")
+      options.stripRows = std::atoi(value.c_str());
+    else if (arg == "--quality")
+      options.quality = std::atoi(value.c_str());
+    else
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  core::Pipeline pipeline;
+  if (!filters::FilterRegistry::buildPipeline(chain, pipeline))
+    return 1;
+
+  core::StreamStats stats;
+  if (!core::StreamProcessor::run(argv[2], argv[3], pipeline, options, &stats))
+    return 1;
+
+  std::cout << "Strips: " << stats.strips << " | Strip memory: " << (stats.peakStripBytes >> 20) << " MB"
+            << (stats.streamedInput && stats.streamedOutput ? "" : " (plus full frame)") << std::endl;
+  std::cout << std::fixed << std::setprecision(1)
+            << "Total: " << stats.seconds << "s for " << stats.megapixels << " MP" << std::endl;
+  std::cout << "Speed: " << (stats.seconds > 0.0 ? stats.megapixels / stats.seconds : 0.0) << " MP/sec" << std::endl;
+
+  return 0;
+}
+
+static int runTui(int argc, char *argv[])
+{
+  if (argc < 3)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  ui::TuiOptions options;
+  int next = 3;
+  if (argc > 3 && std::string(argv[3]).rfind("--", 0) != 0)
+    options.outputPath = argv[next++];
+
+  for (int i = next; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc)
+      options.initialFilter = argv[++i];
+    else
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!filters::FilterRegistry::find(options.initialFilter))
+  {
+    std::cerr << "Error: Unknown filter: " << options.initialFilter << std::endl;
+    return 1;
+  }
+
+  auto image = core::ImageProcessor::loadImage(argv[2]);
+  if (!image)
+    return 1;
+
+  return ui::Tui::run(*image, options);
+}
+
+// Pulls a global "<option> <value>" pair out of the arguments so every mode accepts it.
+static std::string takeOption(int &argc, char *argv[], const std::string &option)
+{
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    if (argv[i] != option)
+      continue;
+
+    std::string path = argv[i + 1];
+    for (int j = i; j + 2 <= argc; j++)
+      argv[j] = argv[j + 2];
+    argc -= 2;
+    return path;
+  }
+  return "";
+}
+
+static int runSingle(int argc, char *argv[], core::ResultCache *cache)
 {
   if (argc != 3)
   {
-    std::cerr << "Usage: " << argv[0] << " <input_image> <output_image>" << std::endl;
+    printUsage(argv[0]);
     return 1;
   }
 
@@ -18,9 +275,36 @@ int main(int argc, char *argv[])
   std::string output_file = argv[2];
 
   auto total_start = std::chrono::high_resolution_clock::now();
+  auto printSpeed = [&](long long pixels)
+  {
+    auto total_end = std::chrono::high_resolution_clock::now();
+    double total_ms = std::chrono::duration<double, std::milli>(total_end - total_start).count();
+    double mp_per_sec = (pixels / 1000000.0) / (total_ms / 1000.0);
 
-  std::cout << "Loading: " << input_file << std::endl;
-  auto load_start = std::chrono::high_resolution_clock::now();
+    std::cout << utils::trace::summary();
+    std::cout << std::fixed << std::setprecision(1) << "Total: " << total_ms << "ms" << '\n';
+    std::cout << "Speed: " << mp_per_sec << " MP/sec" << std::endl;
+  };
+
+  std::optional<core::CacheKey> cacheKey;
+  std::string chainKey;
+  if (cache && filters::FilterRegistry::canonicalSpec("grayscale", chainKey))
+  {
+    if (auto inputKey = core::ResultCache::inputKey(input_file))
+    {
+      cacheKey = core::ResultCache::resultKey(
+          *inputKey, chainKey, core::ResultCache::encoderSignature(output_file, core::EncodeBudget::fastest()));
+      uint64_t pixels = 0;
+      if (cache->fetch(*cacheKey, output_file, &pixels))
+      {
+        std::cout << "Cache hit: " << output_file << std::endl;
+        printSpeed(static_cast<long long>(pixels));
+        return 0;
+      }
+    }
+  }
+
+  std::cout << "Loading: " << input_file << '\n';
 
   auto image = core::ImageProcessor::loadImage(input_file);
   if (!image)
@@ -29,12 +313,7 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  auto load_end = std::chrono::high_resolution_clock::now();
-  auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(load_end - load_start).count();
-  std::cout << "Loaded (" << load_ms << "ms)" << std::endl;
-
-  std::cout << "Converting to grayscale..." << std::endl;
-  auto process_start = std::chrono::high_resolution_clock::now();
+  std::cout << "Converting to grayscale..." << '\n';
 
   auto result = filters::BasicFilters::grayscale(*image);
   if (!result)
@@ -43,12 +322,7 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  auto process_end = std::chrono::high_resolution_clock::now();
-  auto process_ms = std::chrono::duration_cast<std::chrono::milliseconds>(process_end - process_start).count();
-  std::cout << "Processed (" << process_ms << "ms)" << std::endl;
-
-  std::cout << "Saving: " << output_file << std::endl;
-  auto save_start = std::chrono::high_resolution_clock::now();
+  std::cout << "Saving: " << output_file << '\n';
 
   bool success = core::ImageProcessor::saveImageUltraFast(output_file, *result);
   if (!success)
@@ -57,21 +331,66 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  auto save_end = std::chrono::high_resolution_clock::now();
-  auto save_ms = std::chrono::duration_cast<std::chrono::milliseconds>(save_end - save_start).count();
-  std::cout << "Saved (" << save_ms << "ms)" << std::endl;
+  if (cacheKey)
+    cache->store(*cacheKey, output_file, result->getMat().total());
 
-  auto total_end = std::chrono::high_resolution_clock::now();
-  auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(total_end - total_start).count();
+  printSpeed(1LL * image->width() * image->height());
 
-  long long pixels = 1LL * image->width() * image->height();
-  double mp_per_sec = (pixels / 1000000.0) / (total_ms / 1000.0);
+  return 0;
+}
 
-  std::cout << "Load: " << load_ms << "ms | Process: " << process_ms
-            << "ms | Save: " << save_ms << "ms" << std::endl;
-  std::cout << "Total: " << total_ms << "ms" << std::endl;
-  std::cout << "Speed: " << std::fixed << std::setprecision(1)
-            << mp_per_sec << " MP/sec" << std::endl;
+int main(int argc, char *argv[])
+{
+  std::string tracePath = takeOption(argc, argv, "--trace");
+  std::string cacheDir = takeOption(argc, argv, "--cache-dir");
+  std::string cacheMb = takeOption(argc, argv, "--cache-mb");
+#ifndef IMAGETUI_TRACING
+  if (!tracePath.empty())
+    std::cerr << "Warning: built without IMAGETUI_TRACING, --trace output will be empty" << std::endl;
+#endif
 
-  return 0;
-}
\ No newline at end of file
+  std::string mode = argc >= 2 ? argv[1] : "";
+  bool single = mode != "--batch" && mode != "--stream" && mode != "--tui";
+
+  // The single-image run always reports its stage split; the long-running
+  // modes only record when asked to.
+  utils::trace::setEnabled(single || !tracePath.empty());
+
+  // Only the single and batch runs write whole encoded results to reuse.
+  std::unique_ptr<core::ResultCache> cache;
+  if (!cacheDir.empty() && (single || mode == "--batch"))
+  {
+    core::CacheOptions cacheOptions;
+    cacheOptions.directory = cacheDir;
+    if (!cacheMb.empty())
+      cacheOptions.maxDiskBytes = std::strtoull(cacheMb.c_str(), nullptr, 10) << 20;
+    cache = std::make_unique<core::ResultCache>(cacheOptions);
+  }
+  else if (!cacheDir.empty())
+  {
+    std::cerr << "Warning: --cache-dir is ignored in " << mode << " mode" << std::endl;
+  }
+
+  int status;
+  if (mode == "--batch")
+    status = runBatch(argc, argv, cache.get());
+  else if (mode == "--stream")
+    status = runStream(argc, argv);
+  else if (mode == "--tui")
+    status = runTui(argc, argv);
+  else
+    status = runSingle(argc, argv, cache.get());
+
+  if (!tracePath.empty())
+  {
+    if (!single)
+      std::cout << utils::trace::summary() << std::flush;
+
+    if (utils::trace::writeChromeTrace(tracePath))
+      std::cout << "Trace: " << tracePath << std::endl;
+    else
+      std::cerr << "Error: Could not write trace: " << tracePath << std::endl;
+  }
+
+  return status;
+}
@@ -0,0 +1,661 @@
+#include "ui/tui.h"
+#include "filters/registry.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace imagetui
+{
+  namespace ui
+  {
+
+    ImagePyramid::ImagePyramid(const core::ImageData &image, int minSide)
+    {
+      mats.push_back(image.getMat());
+      while (std::min(mats.back().cols, mats.back().rows) / 2 >= minSide)
+      {
+        cv::Mat next;
+        cv::pyrDown(mats.back(), next);
+        mats.push_back(next);
+      }
+    }
+
+    int ImagePyramid::levelFor(cv::Size target) const
+    {
+      for (int i = levels() - 1; i > 0; i--)
+      {
+        if (mats[i].cols >= target.width && mats[i].rows >= target.height)
+          return i;
+      }
+      return 0;
+    }
+
+#ifndef _WIN32
+    namespace
+    {
+      using Clock = std::chrono::high_resolution_clock;
+
+      // How long a lone ESC waits for the rest of an escape sequence before it
+      // counts as the Escape key.
+      constexpr int kEscapeWaitMs = 30;
+
+      constexpr int kTerminalSignals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+      constexpr char kLeaveScreen[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+
+      // Terminal settings to put back if a signal ends the process.
+      termios signalRestore{};
+
+      void restoreAndRaise(int signalNumber)
+      {
+        ssize_t written = ::write(STDOUT_FILENO, kLeaveScreen, sizeof(kLeaveScreen) - 1);
+        (void)written;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &signalRestore);
+        std::signal(signalNumber, SIG_DFL);
+        std::raise(signalNumber);
+      }
+
+      // Raw, unechoed input on the alternate screen for the lifetime of the
+      // object. Ctrl-C arrives as a byte rather than SIGINT; other terminating
+      // signals restore the terminal before the process dies. std::cerr is
+      // captured meanwhile so stray messages don't tear the picture, and
+      // replayed once the terminal is back to normal.
+      class Terminal
+      {
+      public:
+        Terminal()
+        {
+          tcgetattr(STDIN_FILENO, &saved);
+          signalRestore = saved;
+          for (size_t i = 0; i < std::size(kTerminalSignals); i++)
+          {
+            struct sigaction action{};
+            action.sa_handler = restoreAndRaise;
+            sigemptyset(&action.sa_mask);
+            sigaction(kTerminalSignals[i], &action, &savedActions[i]);
+          }
+
+          termios raw = saved;
+          raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+          raw.c_cc[VMIN] = 0;
+          raw.c_cc[VTIME] = 0;
+          tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+
+          savedCerr = std::cerr.rdbuf(captured.rdbuf());
+          write("\x1b[?1049h\x1b[?25l");
+        }
+
+        ~Terminal()
+        {
+          write(kLeaveScreen);
+          tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+          for (size_t i = 0; i < std::size(kTerminalSignals); i++)
+            sigaction(kTerminalSignals[i], &savedActions[i], nullptr);
+          std::cerr.rdbuf(savedCerr);
+          std::cerr << captured.str();
+        }
+
+        Terminal(const Terminal &) = delete;
+        Terminal &operator=(const Terminal &) = delete;
+
+        // Terminal size in character cells.
+        static cv::Size cells()
+        {
+          winsize ws{};
+          if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0)
+            return cv::Size(ws.ws_col, ws.ws_row);
+          return cv::Size(80, 24);
+        }
+
+        // One write per frame; stdio buffering would split it and flicker.
+        static void write(const std::string &text)
+        {
+          size_t done = 0;
+          while (done < text.size())
+          {
+            ssize_t n = ::write(STDOUT_FILENO, text.data() + done, text.size() - done);
+            if (n <= 0)
+              return;
+            done += static_cast<size_t>(n);
+          }
+        }
+
+      private:
+        termios saved{};
+        struct sigaction savedActions[std::size(kTerminalSignals)]{};
+        std::ostringstream captured;
+        std::streambuf *savedCerr = nullptr;
+      };
+
+      enum class Key
+      {
+        Up,
+        Down,
+        Left,
+        Right,
+        Tab,
+        Escape,
+        Char,
+      };
+
+      struct KeyPress
+      {
+        Key key;
+        char ch = 0;
+      };
+
+      // True if the last escape sequence in `buffer` has not reached its
+      // final byte yet.
+      bool partialEscape(const char *buffer, ssize_t n)
+      {
+        ssize_t start = n - 1;
+        while (start >= 0 && buffer[start] != '\x1b')
+          start--;
+        if (start < 0)
+          return false;
+        if (start + 1 == n)
+          return true;
+        if (buffer[start + 1] != '[' && buffer[start + 1] != 'O')
+          return false;
+        for (ssize_t i = start + 2; i < n; i++)
+        {
+          if (buffer[i] >= 0x40 && buffer[i] <= 0x7e)
+            return false;
+        }
+        return true;
+      }
+
+      // Waits up to `timeoutMs` for input and decodes whatever arrived.
+      std::vector<KeyPress> readKeys(int timeoutMs)
+      {
+        std::vector<KeyPress> keys;
+        pollfd fd{STDIN_FILENO, POLLIN, 0};
+        if (poll(&fd, 1, timeoutMs) <= 0)
+          return keys;
+
+        char buffer[64];
+        ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        // A sequence split across reads must not look like a lone Escape.
+        while (n > 0 && n < static_cast<ssize_t>(sizeof(buffer)) && partialEscape(buffer, n) &&
+               poll(&fd, 1, kEscapeWaitMs) > 0)
+        {
+          ssize_t more = read(STDIN_FILENO, buffer + n, sizeof(buffer) - n);
+          if (more <= 0)
+            break;
+          n += more;
+        }
+
+        for (ssize_t i = 0; i < n; i++)
+        {
+          if (buffer[i] == '\x1b' && i + 1 < n && (buffer[i + 1] == '[' || buffer[i + 1] == 'O'))
+          {
+            // Skip parameters up to the final byte; only arrows are used.
+            i += 2;
+            while (i < n && (buffer[i] < 0x40 || buffer[i] > 0x7e))
+              i++;
+            if (i >= n)
+              break;
+            switch (buffer[i])
+            {
+            case 'A':
+              keys.push_back({Key::Up});
+              break;
+            case 'B':
+              keys.push_back({Key::Down});
+              break;
+            case 'C':
+              keys.push_back({Key::Right});
+              break;
+            case 'D':
+              keys.push_back({Key::Left});
+              break;
+            }
+          }
+          else if (buffer[i] == '\x1b' && i + 1 == n)
+            keys.push_back({Key::Escape});
+          else if (buffer[i] == '\x1b')
+            continue; // Alt+key: take the key alone
+          else if (buffer[i] == '\t')
+            keys.push_back({Key::Tab});
+          else
+            keys.push_back({Key::Char, buffer[i]});
+        }
+        return keys;
+      }
+
+      // Largest size with the image's aspect ratio that fits `cells`, counting
+      // two pixels per cell vertically.
+      cv::Size fitToCells(cv::Size image, cv::Size cells)
+      {
+        double scale = std::min(static_cast<double>(cells.width) / image.width,
+                                2.0 * cells.height / image.height);
+        return cv::Size(std::max(1, static_cast<int>(image.width * scale)),
+                        std::max(2, static_cast<int>(image.height * scale)));
+      }
+
+      // Each cell is an upper half block: foreground is the top pixel and
+      // background the bottom one. Color escapes are only sent on change.
+      std::string renderHalfBlocks(const cv::Mat &pixels)
+      {
+        std::string out;
+        out.reserve(pixels.total() * 24);
+        out += "\x1b[H";
+
+        const int channels = pixels.channels();
+        auto rgb = [&](int y, int x)
+        {
+          if (y >= pixels.rows)
+            return 0;
+          const uchar *p = pixels.ptr<uchar>(y) + x * channels;
+          return channels >= 3 ? (p[2] << 16) | (p[1] << 8) | p[0] : (p[0] << 16) | (p[0] << 8) | p[0];
+        };
+
+        char escape[48];
+        for (int y = 0; y < pixels.rows; y += 2)
+        {
+          int lastFg = -1, lastBg = -1;
+          for (int x = 0; x < pixels.cols; x++)
+          {
+            int fg = rgb(y, x), bg = rgb(y + 1, x);
+            if (fg != lastFg)
+            {
+              std::snprintf(escape, sizeof(escape), "\x1b[38;2;%d;%d;%dm", fg >> 16, (fg >> 8) & 255, fg & 255);
+              out += escape;
+              lastFg = fg;
+            }
+            if (bg != lastBg)
+            {
+              std::snprintf(escape, sizeof(escape), "\x1b[48;2;%d;%d;%dm", bg >> 16, (bg >> 8) & 255, bg & 255);
+              out += escape;
+              lastBg = bg;
+            }
+            out += "\xe2\x96\x80";
+          }
+          out += "\x1b[0m\x1b[K\r\n";
+        }
+        out += "\x1b[J";
+        return out;
+      }
+
+      // The filter being tuned and its arguments, edited in place. Arguments
+      // are whatever the registry declares as defaults: integers step by one,
+      // decimals by 0.05.
+      class FilterState
+      {
+      public:
+        explicit FilterState(const std::string &initial)
+        {
+          const auto &all = filters::FilterRegistry::filters();
+          for (size_t i = 0; i < all.size(); i++)
+          {
+            if (all[i].name == initial)
+              index = i;
+          }
+          select(index);
+        }
+
+        void next() { select((index + 1) % filters::FilterRegistry::filters().size()); }
+
+        void nextParam(int direction)
+        {
+          if (!args.empty())
+            param = (param + direction + static_cast<int>(args.size())) % static_cast<int>(args.size());
+        }
+
+        // Steps the selected argument; reverts if the filter rejects the value.
+        bool adjust(int direction)
+        {
+          if (args.empty())
+            return false;
+
+          std::string previous = args[param];
+          std::string &arg = args[param];
+          char text[32];
+          if (arg.find('.') != std::string::npos)
+            std::snprintf(text, sizeof(text), "%.2f", std::stod(arg) + 0.05 * direction);
+          else
+            std::snprintf(text, sizeof(text), "%d", std::stoi(arg) + direction);
+          arg = text;
+
+          core::Pipeline probe;
+          if (!filters::FilterRegistry::buildPipeline(spec(), probe))
+          {
+            arg = previous;
+            return false;
+          }
+          return true;
+        }
+
+        std::string spec() const
+        {
+          std::string text = filters::FilterRegistry::filters()[index].name;
+          for (const auto &arg : args)
+            text += ":" + arg;
+          return text;
+        }
+
+        // The spec with the selected argument bracketed, for the status line.
+        std::string label() const
+        {
+          std::string text = filters::FilterRegistry::filters()[index].name;
+          for (size_t i = 0; i < args.size(); i++)
+            text += static_cast<int>(i) == param ? ":[" + args[i] + "]" : ":" + args[i];
+          return text;
+        }
+
+      private:
+        void select(size_t i)
+        {
+          index = i;
+          args = filters::FilterRegistry::filters()[index].defaults;
+          param = 0;
+        }
+
+        size_t index = 0;
+        std::vector<std::string> args;
+        int param = 0;
+      };
+
+      // Builds `spec` for one pyramid level, with pixel arguments such as radii
+      // shrunk to the level's size so every level previews the same look.
+      bool buildForLevel(const std::string &spec, const ImagePyramid &pyramid, int level, core::Pipeline &pipeline)
+      {
+        const double scale = static_cast<double>(pyramid.level(level).cols) / pyramid.level(0).cols;
+        return filters::FilterRegistry::buildPipeline(spec, pipeline, scale);
+      }
+
+      struct RefineJob
+      {
+        uint64_t generation = 0;
+        std::string spec;
+        // Level already shown; refinement runs the levels below it.
+        int fromLevel = 0;
+        std::shared_ptr<core::CancelToken> cancel;
+      };
+
+      struct Refined
+      {
+        uint64_t generation;
+        int level;
+        cv::Mat mat;
+      };
+
+      // Background worker that re-runs the current chain on successively
+      // larger pyramid levels. Submitting a job cancels the one in flight.
+      class Refiner
+      {
+      public:
+        explicit Refiner(const ImagePyramid &pyramid) : pyramid(pyramid), worker([this]
+                                                                                 { loop(); })
+        {
+        }
+
+        ~Refiner()
+        {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            if (current.cancel)
+              current.cancel->store(true);
+          }
+          wake.notify_one();
+          worker.join();
+        }
+
+        void submit(RefineJob job)
+        {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (current.cancel)
+              current.cancel->store(true);
+            current = std::move(job);
+            pending = true;
+            finished.reset();
+          }
+          wake.notify_one();
+        }
+
+        std::optional<Refined> take()
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          std::optional<Refined> result = std::move(finished);
+          finished.reset();
+          return result;
+        }
+
+        bool busy() const
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          return pending || running;
+        }
+
+      private:
+        void loop()
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          while (true)
+          {
+            wake.wait(lock, [&]
+                      { return stopping || pending; });
+            if (stopping)
+              return;
+
+            RefineJob job = current;
+            pending = false;
+            running = true;
+
+            for (int level = job.fromLevel - 1; level >= 0 && !job.cancel->load(); level--)
+            {
+              lock.unlock();
+              core::Pipeline pipeline;
+              std::unique_ptr<core::ImageData> result;
+              if (buildForLevel(job.spec, pyramid, level, pipeline))
+                result = pipeline.run(core::ImageData(pyramid.level(level)), job.cancel.get());
+              lock.lock();
+
+              if (!result || job.cancel->load())
+                break;
+              finished = Refined{job.generation, level, result->getMat()};
+            }
+            running = false;
+          }
+        }
+
+        const ImagePyramid &pyramid;
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+        RefineJob current;
+        bool pending = false;
+        bool running = false;
+        bool stopping = false;
+        std::optional<Refined> finished;
+        std::thread worker;
+      };
+    }
+
+    int Tui::run(const core::ImageData &image, const TuiOptions &options)
+    {
+      if (!image.isValid())
+        return 1;
+
+      if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+      {
+        std::cerr << "Error: --tui needs an interactive terminal" << std::endl;
+        return 1;
+      }
+
+      const ImagePyramid pyramid(image);
+      FilterState filter(options.initialFilter);
+      Refiner refiner(pyramid);
+      Terminal terminal;
+
+      uint64_t generation = 0;
+      cv::Size cells;
+      cv::Mat frame;        // filtered output of the level on screen
+      int frameLevel = 0;
+      cv::Mat fullResult;   // level 0 output, once refinement gets there
+      double previewMs = 0.0;
+      bool showOriginal = false;
+      std::string message;
+
+      auto redraw = [&]
+      {
+        const cv::Mat &source = showOriginal ? pyramid.level(frameLevel) : frame;
+        cv::Size target = fitToCells(source.size(), cv::Size(cells.width, cells.height - 1));
+        cv::Mat pixels;
+        cv::resize(source, pixels, target, 0, 0, cv::INTER_AREA);
+
+        std::ostringstream status;
+        status << "\x1b[7m " << filter.label() << " | level " << frameLevel << "/" << pyramid.levels() - 1 << " ("
+               << source.cols << "x" << source.rows << ") preview " << static_cast<int>(previewMs + 0.5) << "ms"
+               << (refiner.busy() ? " | refining" : "") << (showOriginal ? " | original" : "")
+               << (message.empty() ? "" : " | " + message)
+               << " | tab filter, </> param, ^/v value, o orig, s save, q quit \x1b[0m\x1b[K";
+
+        Terminal::write(renderHalfBlocks(pixels) + status.str());
+      };
+
+      // Filters the level that fits the terminal right away, then hands the
+      // larger levels to the refiner.
+      auto refresh = [&]
+      {
+        cv::Size target = fitToCells(pyramid.level(0).size(), cv::Size(cells.width, cells.height - 1));
+        const int level = pyramid.levelFor(target);
+        core::Pipeline pipeline;
+        if (!buildForLevel(filter.spec(), pyramid, level, pipeline))
+          return;
+
+        generation++;
+        fullResult.release();
+        frameLevel = level;
+
+        auto start = Clock::now();
+        auto preview = pipeline.run(core::ImageData(pyramid.level(frameLevel)));
+        previewMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (!preview)
+          return;
+        frame = preview->getMat();
+        if (frameLevel == 0)
+          fullResult = frame;
+
+        RefineJob job;
+        job.generation = generation;
+        job.spec = filter.spec();
+        job.fromLevel = frameLevel;
+        job.cancel = std::make_shared<core::CancelToken>(false);
+        refiner.submit(std::move(job));
+
+        redraw();
+      };
+
+      cells = Terminal::cells();
+      refresh();
+
+      while (true)
+      {
+        bool changed = false;
+        for (const auto &press : readKeys(50))
+        {
+          message.clear();
+          switch (press.key)
+          {
+          case Key::Escape:
+            return 0;
+          case Key::Tab:
+            filter.next();
+            changed = true;
+            break;
+          case Key::Left:
+            filter.nextParam(-1);
+            redraw();
+            break;
+          case Key::Right:
+            filter.nextParam(1);
+            redraw();
+            break;
+          case Key::Up:
+            changed |= filter.adjust(1);
+            break;
+          case Key::Down:
+            changed |= filter.adjust(-1);
+            break;
+          case Key::Char:
+            if (press.ch == 'q' || press.ch == '\x03')
+              return 0;
+            if (press.ch == '+' || press.ch == '=')
+              changed |= filter.adjust(1);
+            else if (press.ch == '-')
+              changed |= filter.adjust(-1);
+            else if (press.ch == 'o')
+            {
+              showOriginal = !showOriginal;
+              redraw();
+            }
+            else if (press.ch == 's')
+            {
+              if (options.outputPath.empty())
+                message = "no output path given";
+              else if (fullResult.empty())
+                message = "still refining";
+              else
+                message = core::ImageProcessor::saveImageFast(options.outputPath, core::ImageData(fullResult))
+                              ? "saved " + options.outputPath
+                              : "save failed";
+              redraw();
+            }
+            break;
+          }
+        }
+
+        cv::Size now = Terminal::cells();
+        if (now != cells)
+        {
+          cells = now;
+          changed = true;
+        }
+
+        if (changed)
+        {
+          refresh();
+          continue;
+        }
+
+        if (auto refined = refiner.take())
+        {
+          if (refined->generation == generation && refined->level < frameLevel)
+          {
+            frame = refined->mat;
+            frameLevel = refined->level;
+            if (frameLevel == 0)
+              fullResult = frame;
+            redraw();
+          }
+        }
+      }
+    }
+#else
+    int Tui::run(const core::ImageData &, const TuiOptions &)
+    {
+      std::cerr << "Error: --tui is only available on POSIX terminals" << std::endl;
+      return 1;
+    }
+#endif
+
+  }
+}
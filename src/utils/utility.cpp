@@ -0,0 +1,198 @@
+#include "utils/utility.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace imagetui
+{
+  namespace utils
+  {
+    namespace trace
+    {
+
+      namespace
+      {
+        struct Event
+        {
+          const char *name;
+          uint64_t startNs;
+          uint64_t endNs;
+        };
+
+        // 64K events (1.5 MB) per thread before the oldest get overwritten.
+        constexpr uint64_t kRingSize = uint64_t(1) << 16;
+
+        // Written only by its owning thread; head is published with release so
+        // a reader that acquires it sees every event below it.
+        struct ThreadRing
+        {
+          uint32_t tid = 0;
+          std::unique_ptr<Event[]> events{new Event[kRingSize]};
+          std::atomic<uint64_t> head{0};
+          bool owned = true; // guarded by registryMutex
+        };
+
+        // Rings outlive their threads so a batch's worker spans can still be
+        // exported after the workers have exited. A new thread takes over a
+        // released ring, so its events share that ring's track.
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadRing>> registry;
+
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        // Releases the thread's ring when the thread exits.
+        struct RingLease
+        {
+          ThreadRing *ring = nullptr;
+
+          ~RingLease()
+          {
+            if (!ring)
+              return;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            ring->owned = false;
+          }
+        };
+
+        ThreadRing &localRing()
+        {
+          thread_local RingLease lease;
+          if (!lease.ring)
+          {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (const auto &ring : registry)
+            {
+              if (!ring->owned)
+              {
+                lease.ring = ring.get();
+                break;
+              }
+            }
+            if (!lease.ring)
+            {
+              registry.push_back(std::make_unique<ThreadRing>());
+              lease.ring = registry.back().get();
+              lease.ring->tid = static_cast<uint32_t>(registry.size());
+            }
+            lease.ring->owned = true;
+          }
+          return *lease.ring;
+        }
+
+        template <typename Visitor>
+        void forEachEvent(Visitor visit)
+        {
+          std::lock_guard<std::mutex> lock(registryMutex);
+          for (const auto &ring : registry)
+          {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > kRingSize ? head - kRingSize : 0;
+            for (uint64_t i = first; i < head; i++)
+              visit(ring->tid, ring->events[i & (kRingSize - 1)]);
+          }
+        }
+      }
+
+      uint64_t nowNs()
+      {
+        // +1 keeps a real timestamp from ever reading as "not started".
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - epoch)
+                                         .count()) +
+               1;
+      }
+
+      void record(const char *name, uint64_t startNs, uint64_t endNs)
+      {
+        ThreadRing &ring = localRing();
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        ring.events[head & (kRingSize - 1)] = Event{name, startNs, endNs};
+        ring.head.store(head + 1, std::memory_order_release);
+      }
+
+      std::vector<StageSummary> summarize()
+      {
+        std::map<std::string, std::vector<uint64_t>> durations;
+        forEachEvent([&](uint32_t, const Event &event)
+                     { durations[event.name].push_back(event.endNs - event.startNs); });
+
+        std::vector<StageSummary> stages;
+        for (auto &[name, samples] : durations)
+        {
+          std::sort(samples.begin(), samples.end());
+
+          StageSummary stage;
+          stage.name = name;
+          stage.count = samples.size();
+          for (uint64_t ns : samples)
+            stage.totalMs += ns / 1e6;
+          stage.meanMs = stage.totalMs / stage.count;
+          stage.p50Ms = samples[samples.size() / 2] / 1e6;
+          stage.p99Ms = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)] / 1e6;
+          stage.maxMs = samples.back() / 1e6;
+          stages.push_back(stage);
+        }
+
+        std::sort(stages.begin(), stages.end(), [](const StageSummary &a, const StageSummary &b)
+                  { return a.totalMs > b.totalMs; });
+        return stages;
+      }
+
+      std::string summary()
+      {
+        const auto stages = summarize();
+        if (stages.empty())
+          return "";
+
+        std::ostringstream out;
+        out << std::left << std::setw(22) << "stage" << std::right << std::setw(8) << "count"
+            << std::setw(12) << "total ms" << std::setw(10) << "mean" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+        out << std::fixed << std::setprecision(3);
+
+        for (const auto &stage : stages)
+        {
+          out << std::left << std::setw(22) << stage.name << std::right << std::setw(8) << stage.count
+              << std::setw(12) << stage.totalMs << std::setw(10) << stage.meanMs << std::setw(10) << stage.p50Ms
+              << std::setw(10) << stage.p99Ms << std::setw(10) << stage.maxMs << "\n";
+        }
+        return out.str();
+      }
+
+      bool writeChromeTrace(const std::string &path)
+      {
+        std::ofstream out(path);
+        if (!out)
+          return false;
+
+        // Complete ("X") events in microseconds, one track per thread.
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        out << std::fixed << std::setprecision(3);
+        bool first = true;
+        forEachEvent([&](uint32_t tid, const Event &event)
+                     {
+          out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"imagetui\",\"ph\":\"X\",\"pid\":1"
+              << ",\"tid\":" << tid << ",\"ts\":" << event.startNs / 1e3
+              << ",\"dur\":" << (event.endNs - event.startNs) / 1e3 << "}";
+          first = false; });
+        out << "\n]}\n";
+
+        return static_cast<bool>(out);
+      }
+
+      void reset()
+      {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto &ring : registry)
+          ring->head.store(0, std::memory_order_release);
+      }
+
+    }
+  }
+}